@@ -148,6 +148,62 @@ tests ()
     assert (h5.begin () == h5.end ());
     assert (h5.find (test.extra ()) == h5.end ());
   }
+
+  std::cout << "6" << std::flush;
+  {
+    // Insert a batch into a table that has some of its keys already,
+    // with some keys twice in the batch.  The element that comes
+    // first stays, as with std::map.
+    typedef std::pair<typename H::key_type, typename H::mapped_type> pair;
+    H h6;
+    std::map<typename H::key_type, typename H::mapped_type> m;
+    for (size_t i = 0; i < vals.size (); i += 2)
+      {
+	h6.insert (vals[i]);
+	m.insert (vals[i]);
+      }
+    std::vector<pair> batch;
+    for (size_t i = vals.size (); i-- > 0; )
+      {
+	batch.push_back (std::make_pair (vals[i].first, test.extra ()));
+	if (i % 3 == 0)
+	  batch.push_back (vals[i]);
+      }
+    h6.insert (batch.begin (), batch.end ());
+    m.insert (batch.begin (), batch.end ());
+    assert (h6.size () == m.size ());
+    assert (std::equal (h6.begin (), h6.end (), m.begin (),
+			[] (pair const &a, pair const &b)
+			{
+			  return a == b;
+			}));
+  }
+}
+
+// Construction from a range, which is sorted and deduplicated, and
+// from a range that's known to be sorted and unique already.
+template <class H, int M>
+void
+construction_tests ()
+{
+  TestVector<M, typename H::key_type> const test;
+  std::vector<std::pair<typename H::key_type, typename H::mapped_type> > vals;
+  H h;
+  for (auto i = test.begin (); i != test.end (); ++i)
+    {
+      vals.push_back (std::make_pair (*i, *i));
+      h.insert (vals.back ());
+    }
+
+  std::cout << "7" << std::flush;
+  H h2 (vals.rbegin (), vals.rend ());
+  assert (h2 == h);
+  vals.insert (vals.end (), vals.begin (), vals.end ());
+  H h3 (vals.begin (), vals.end ());
+  assert (h3 == h);
+
+  H h4 (sorted_unique, h.begin (), h.end ());
+  assert (h4 == h);
 }
 
 template <int N>
@@ -161,9 +217,11 @@ testsuite ()
 
   std::cout << std::endl << " + assoc_vec int->int " << std::flush;
   tests<assoc_vec<int, int>, N> ();
+  construction_tests<assoc_vec<int, int>, N> ();
 
   std::cout << std::endl << " + assoc_vec string->string " << std::flush;
   tests<assoc_vec<std::string, std::string>, N> ();
+  construction_tests<assoc_vec<std::string, std::string>, N> ();
 
   std::cout << std::endl;
 }
@@ -23,6 +23,12 @@
 #include <vector>
 #include <functional>
 #include <algorithm>
+#include <cassert>
+
+// Tag for constructing an assoc_vec from a range that is already
+// sorted by key and has no key twice.
+struct sorted_unique_t {};
+const sorted_unique_t sorted_unique = sorted_unique_t ();
 
 template<class Key, class T,
 	 class Compare = std::less<Key>,
@@ -66,8 +72,21 @@ public:
 
   template <class Iterator>
   assoc_vec (Iterator begin, Iterator end)
+  {
+    insert (begin, end);
+  }
+
+  // The range is taken as it is, without sorting.
+  template <class Iterator>
+  assoc_vec (sorted_unique_t, Iterator begin, Iterator end)
     : _vec (begin, end)
-  {}
+  {
+    assert (std::adjacent_find (_vec.begin (), _vec.end (),
+				[] (value_type const &a, value_type const &b)
+				{
+				  return !(a.first < b.first);
+				}) == _vec.end ());
+  }
 
   bool
   operator == (assoc_vec const &other) const
@@ -173,12 +192,35 @@ public:
     return insert (emt);
   }
 
+  // Append the new elements, sort them and merge them with the old
+  // ones, which is O(n + k log k) instead of O(n k) for k one by one
+  // inserts.  As with those, of the elements with the same key, the
+  // one that was there first stays.
   template <class InputIterator>
   void
   insert (InputIterator first, InputIterator last)
   {
-    for (; first != last; ++first)
-      insert (*first);
+    auto less = [] (value_type const &a, value_type const &b)
+      {
+	return a.first < b.first;
+      };
+    auto same = [] (value_type const &a, value_type const &b)
+      {
+	return a.first == b.first;
+      };
+
+    size_type n = _vec.size ();
+    _vec.insert (_vec.end (), first, last);
+    std::stable_sort (_vec.begin () + n, _vec.end (), less);
+    _vec.erase (std::unique (_vec.begin () + n, _vec.end (), same),
+		_vec.end ());
+    if (n > 0 && n < _vec.size ())
+      {
+	std::inplace_merge (_vec.begin (), _vec.begin () + n, _vec.end (),
+			    less);
+	_vec.erase (std::unique (_vec.begin (), _vec.end (), same),
+		    _vec.end ());
+      }
   }
 };
 
@@ -0,0 +1,177 @@
+/*
+ * Test suite for fixed-size lock-free stack and object pool.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "atomic_slist.hh"
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum { nthreads = 4 };
+
+template <size_t N>
+void
+single_thread_tests ()
+{
+  std::cout << std::endl << " + single thread N=" << N << " " << std::flush;
+  atomic_slist<std::string, N> s;
+  assert (s.empty ());
+
+  std::cout << "0" << std::flush;
+  for (size_t i = 0; i < N; ++i)
+    s.push_front (std::to_string (i));
+  bool thrown = false;
+  try
+    {
+      s.push_front ("x");
+    }
+  catch (std::bad_alloc const &)
+    {
+      thrown = true;
+    }
+  assert (thrown);
+
+  std::cout << "1" << std::flush;
+  std::string v;
+  for (size_t i = N; i-- > 0; )
+    {
+      assert (s.pop_front (v));
+      assert (v == std::to_string (i));
+    }
+  assert (!s.pop_front (v));
+  assert (s.empty ());
+
+  // Leave some elements in, for the destructor.
+  std::cout << "2" << std::flush;
+  for (size_t i = 0; i < N / 2; ++i)
+    s.push_front (std::string (100, 'a'));
+}
+
+// Each thread pushes its own numbers and pops whatever is on top.
+// In the end, every number has to be popped exactly once.
+template <size_t N>
+void
+stack_stress ()
+{
+  std::cout << std::endl << " + stack stress N=" << N << " " << std::flush;
+  enum { rounds = 200000 };
+  atomic_slist<int, N> s;
+  std::vector<std::vector<int>> popped (nthreads);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nthreads; ++t)
+    threads.push_back (std::thread ([&s, &popped, t] ()
+      {
+	int v;
+	for (int i = 0; i < rounds; ++i)
+	  {
+	    for (;;)
+	      try
+		{
+		  s.push_front (t * rounds + i);
+		  break;
+		}
+	      catch (std::bad_alloc const &)
+		{
+		  if (s.pop_front (v))
+		    popped[t].push_back (v);
+		}
+	    if (i % 3 != 0 && s.pop_front (v))
+	      popped[t].push_back (v);
+	  }
+      }));
+  for (auto it = threads.begin (); it != threads.end (); ++it)
+    it->join ();
+
+  int v;
+  while (s.pop_front (v))
+    popped[0].push_back (v);
+
+  std::vector<char> seen (nthreads * rounds, 0);
+  for (int t = 0; t < nthreads; ++t)
+    for (auto it = popped[t].begin (); it != popped[t].end (); ++it)
+      {
+	assert (*it >= 0 && *it < nthreads * rounds);
+	assert (!seen[*it]);
+	seen[*it] = 1;
+      }
+  for (auto it = seen.begin (); it != seen.end (); ++it)
+    assert (*it);
+  std::cout << "ok" << std::flush;
+}
+
+// Threads take objects from a shared pool, tag them with their id,
+// and check that nobody else touched them before giving them back.
+template <size_t N>
+void
+pool_stress ()
+{
+  std::cout << std::endl << " + pool stress N=" << N << " " << std::flush;
+  enum { rounds = 200000, hold = 4 };
+  atomic_slist<std::atomic<int>, N> pool;
+  std::atomic<int> failures (0);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nthreads; ++t)
+    threads.push_back (std::thread ([&pool, &failures, t] ()
+      {
+	std::atomic<int> *held[hold];
+	for (int i = 0; i < rounds; ++i)
+	  {
+	    for (int j = 0; j < hold; ++j)
+	      held[j] = pool.take (t);
+	    for (int j = 0; j < hold; ++j)
+	      held[j]->store (t * hold + j);
+	    for (int j = 0; j < hold; ++j)
+	      if (held[j]->load () != t * hold + j)
+		++failures;
+	    for (int j = 0; j < hold; ++j)
+	      pool.give (held[j]);
+	  }
+      }));
+  for (auto it = threads.begin (); it != threads.end (); ++it)
+    it->join ();
+  assert (failures == 0);
+
+  // All slots are back.
+  std::vector<std::atomic<int> *> all;
+  for (size_t i = 0; i < N; ++i)
+    all.push_back (pool.take (0));
+  for (auto it = all.begin (); it != all.end (); ++it)
+    pool.give (*it);
+  std::cout << "ok" << std::flush;
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::cout << "running atomic_slist tests" << std::flush;
+  single_thread_tests<1> ();
+  single_thread_tests<17> ();
+  single_thread_tests<1024> ();
+  stack_stress<16> ();
+  stack_stress<100000> ();
+  pool_stress<nthreads * 4> ();
+  pool_stress<1024> ();
+  std::cout << std::endl;
+}
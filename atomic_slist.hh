@@ -0,0 +1,253 @@
+/*
+ * Implementation of fixed-size lock-free stack and object pool.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The slot pool of slist, made safe for concurrent use.  Like in
+ * slist, slots are linked by 32-bit indices.  Both the list itself
+ * and the free list are Treiber stacks: the top of each is a 64-bit
+ * word that holds the index together with a tag, and every change of
+ * the top goes through compare-and-swap.  The tag is bumped on each
+ * change, so that a thread that read the top, then got preempted
+ * while the slot was popped and pushed back, fails its CAS instead of
+ * installing a stale link (the ABA problem).
+ *
+ * Slots that were never used are handed out from an atomic bump
+ * index, so construction is O(1) as in slist.
+ *
+ * There's no iteration, and elements are popped by value, because
+ * another thread may pop and reuse a slot at any moment.  The same
+ * pool can also be used directly, with take and give.  */
+
+#ifndef _ATOMIC_SLIST_H_
+#define _ATOMIC_SLIST_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template<class T, size_t N>
+class atomic_slist
+{
+  static_assert (N < UINT32_MAX, "slot indices have 32 bits");
+
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+  typedef value_type &reference;
+  typedef const value_type &const_reference;
+  typedef value_type *pointer;
+  typedef const value_type *const_pointer;
+
+private:
+  typedef uint32_t index_type;
+
+  struct alignas (T) slot
+  {
+    unsigned char bytes[sizeof (T)]; // payload
+  };
+
+  // Index in the low half, tag in the high half.  Index N means the
+  // stack is empty.
+  class top
+  {
+    std::atomic<uint64_t> _word;
+
+  public:
+    static index_type
+    index (uint64_t word)
+    {
+      return index_type (word);
+    }
+
+    static uint64_t
+    next_word (uint64_t word, index_type i)
+    {
+      return ((word >> 32) + 1) << 32 | i;
+    }
+
+    top ()
+      : _word (N)
+    {}
+
+    uint64_t
+    load () const
+    {
+      return _word.load (std::memory_order_acquire);
+    }
+
+    bool
+    cas (uint64_t &expect, uint64_t desired)
+    {
+      return _word.compare_exchange_weak (expect, desired,
+					  std::memory_order_acq_rel,
+					  std::memory_order_acquire);
+    }
+  };
+
+  slot _slots[N];
+  // Racing poppers may read a link just as it's rewritten.  Their CAS
+  // then fails, but the read itself has to be atomic.
+  std::atomic<index_type> _nexts[N];
+  top _head;
+  top _free;
+  std::atomic<index_type> _bump;
+
+  reference
+  payload (index_type i)
+  {
+    return *reinterpret_cast<pointer> (_slots[i].bytes);
+  }
+
+  void
+  push (top &stack, index_type i)
+  {
+    uint64_t word = stack.load ();
+    do
+      _nexts[i].store (top::index (word), std::memory_order_relaxed);
+    while (!stack.cas (word, top::next_word (word, i)));
+  }
+
+  // Answer N if STACK is empty.
+  index_type
+  pop (top &stack)
+  {
+    uint64_t word = stack.load ();
+    for (;;)
+      {
+	index_type i = top::index (word);
+	if (i == N)
+	  return N;
+	index_type next = _nexts[i].load (std::memory_order_relaxed);
+	if (stack.cas (word, top::next_word (word, next)))
+	  return i;
+      }
+  }
+
+  index_type
+  take_slot ()
+  {
+    index_type i = pop (_free);
+    if (i != N)
+      return i;
+
+    i = _bump.load (std::memory_order_relaxed);
+    while (i < N)
+      if (_bump.compare_exchange_weak (i, i + 1, std::memory_order_relaxed))
+	return i;
+
+    // Some other thread may have returned a slot in the meantime.
+    i = pop (_free);
+    if (i == N)
+      throw std::bad_alloc ();
+    return i;
+  }
+
+  index_type
+  index_of (const_pointer p) const
+  {
+    return reinterpret_cast<slot const *> (p) - _slots;
+  }
+
+public:
+  atomic_slist ()
+    : _bump (0)
+  {}
+
+  atomic_slist (atomic_slist const &) = delete;
+  atomic_slist &operator = (atomic_slist const &) = delete;
+
+  // No other thread may be using the list at this point.  Objects
+  // obtained by take and not given back are not destroyed.
+  ~atomic_slist ()
+  {
+    if (!std::is_trivially_destructible<T>::value)
+      for (index_type i = _head.index (_head.load ()); i != N;
+	   i = _nexts[i].load (std::memory_order_relaxed))
+	payload (i).~T ();
+  }
+
+  // Construct a T in a free slot and answer a pointer to it.  Throws
+  // std::bad_alloc if there's no free slot.
+  template <class... Args>
+  pointer
+  take (Args &&... args)
+  {
+    index_type i = take_slot ();
+    try
+      {
+	return new (_slots[i].bytes) T (std::forward<Args> (args)...);
+      }
+    catch (...)
+      {
+	push (_free, i);
+	throw;
+      }
+  }
+
+  // Destroy an object obtained by take and return its slot.
+  void
+  give (pointer p)
+  {
+    index_type i = index_of (p);
+    p->~T ();
+    push (_free, i);
+  }
+
+  void
+  push_front (const T &value)
+  {
+    push (_head, index_of (take (value)));
+  }
+
+  void
+  push_front (T &&value)
+  {
+    push (_head, index_of (take (std::move (value))));
+  }
+
+  // Move the front element to VALUE and remove it.  Answer false if
+  // the list was empty.
+  bool
+  pop_front (T &value)
+  {
+    index_type i = pop (_head);
+    if (i == N)
+      return false;
+    value = std::move (payload (i));
+    give (&payload (i));
+    return true;
+  }
+
+  // This is only a snapshot, other threads may change it right away.
+  bool
+  empty () const
+  {
+    return top::index (_head.load ()) == N;
+  }
+
+  size_type
+  max_size () const
+  {
+    return N;
+  }
+};
+
+#endif /* _ATOMIC_SLIST_H_ */
@@ -0,0 +1,101 @@
+/*
+ * Test suite for cache-line blocked Bloom filter.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bloom.hh"
+#include "tests.hh"
+
+#include <cassert>
+#include <iostream>
+#include <set>
+#include <string>
+
+template <class Key, int N>
+void
+tests ()
+{
+  typedef bloom_filter<Key, N> F;
+  std::cout << std::endl << " + " << typeid (Key).name ()
+	    << " N=" << N << " blocks=" << F::nblocks
+	    << " hashes=" << F::nhashes << " " << std::flush;
+  assert (F::nhashes >= 1 && F::nhashes <= 7);
+
+  TestVector<N, Key> const test;
+  // Not allocated with new, C++11 doesn't honor the alignment of
+  // blocks there.
+  F filter, *f = &filter;
+
+  std::cout << "0" << std::flush;
+  for (auto i = test.begin (); i != test.end (); ++i)
+    assert (!f->may_contain (*i));
+
+  std::cout << "1" << std::flush;
+  for (auto i = test.begin (); i != test.end (); ++i)
+    f->insert (*i);
+
+  // No false negatives, ever.
+  std::cout << "2" << std::flush;
+  for (auto i = test.begin (); i != test.end (); ++i)
+    assert (f->may_contain (*i));
+
+  // The false positive rate on keys that were never inserted should
+  // be in the ballpark of the nominal 1%.
+  std::cout << "3" << std::flush;
+  {
+    TestVector<N * 2, Key> const other;
+    std::set<Key> const inserted (test.begin (), test.end ());
+    size_t fp = 0, total = 0;
+    for (auto i = other.begin (); i != other.end (); ++i)
+      if (inserted.find (*i) == inserted.end ())
+	{
+	  ++total;
+	  if (f->may_contain (*i))
+	    ++fp;
+	}
+    std::cout << "(" << fp << "/" << total << ")" << std::flush;
+    assert (fp <= total / 20 + 1);
+  }
+
+  std::cout << "4" << std::flush;
+  {
+    F g;
+    g.swap (*f);
+    for (auto i = test.begin (); i != test.end (); ++i)
+      assert (g.may_contain (*i));
+    g.swap (*f);
+  }
+
+  std::cout << "5" << std::flush;
+  f->insert (test.front ());
+  f->clear ();
+  assert (!f->may_contain (test.front ()));
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::cout << "running bloom_filter tests" << std::flush;
+  tests<int, 1> ();
+  tests<int, 17> ();
+  tests<int, 1021> ();
+  tests<int, 65521> ();
+  tests<std::string, 17> ();
+  tests<std::string, 1021> ();
+  tests<std::string, 4093> ();
+  std::cout << std::endl;
+}
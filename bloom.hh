@@ -0,0 +1,343 @@
+/*
+ * Implementation of cache-line blocked Bloom filter, and of a
+ * hashtab adaptor that consults the filter before probing.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Each key maps to one 64-byte block, and all its bits are set
+ * within that block.  A lookup thus costs at most one cache miss,
+ * compared to one miss per hash function with a classic Bloom
+ * filter.  The price is a somewhat higher false positive rate for
+ * the same number of bits, about 1% at ten bits per key.
+ *
+ * N is the expected number of elements.  The filter keeps working
+ * past that, but the false positive rate goes up.
+ *
+ * Blocks are aligned to cache lines, but operator new doesn't honor
+ * that before C++17.  A filter on the heap still works, the blocks are
+ * read with unaligned loads, but a block may then straddle two lines.
+ * Keep filters on the stack, in static storage or in aligned memory
+ * to get the one miss per lookup.  */
+
+#ifndef _BLOOM_H_
+#define _BLOOM_H_
+
+#include "hash.hh"
+#include "hashers.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+template <class Key, size_t N, class Hash = std::hash<Key>>
+class bloom_filter
+{
+public:
+  typedef Key key_type;
+  typedef size_t size_type;
+  typedef Hash hasher;
+
+private:
+  typedef uint64_t word_type;
+  static const size_type block_words = 8;
+  static const size_type block_bits = block_words * 64;
+  static const size_type bits_per_key = 10;
+
+public:
+  static const size_type nblocks
+    = N * bits_per_key <= block_bits
+      ? 1 : (N * bits_per_key + block_bits - 1) / block_bits;
+
+private:
+  // The optimal number of hash functions is (m / n) ln 2.
+  static const size_type ideal_hashes
+    = nblocks * block_bits * 693 / ((N > 0 ? N : 1) * 1000);
+
+public:
+  // We take nine bits of a 64-bit hash per function, which caps this
+  // at seven.  That's about where the curve flattens out anyway.
+  static const unsigned nhashes
+    = ideal_hashes > 7 ? 7 : ideal_hashes < 1 ? 1 : ideal_hashes;
+
+private:
+  struct alignas (64) block
+  {
+    word_type words[block_words];
+  };
+
+  block _blocks[nblocks];
+  hasher _hash;
+
+  // Pick the block from upper half of the hash, and derive the mask
+  // of bits to test within the block from a second round of mixing.
+  // The first round is there because user hashes may be poor
+  // (std::hash<int> is the identity).
+  size_type
+  locate (key_type const &key, word_type mask[block_words]) const
+  {
+    uint64_t h = mix64 (_hash (key));
+    uint64_t g = mix64 (h ^ 0x9e3779b97f4a7c15ULL);
+
+    std::fill (mask, mask + block_words, word_type (0));
+    for (unsigned i = 0; i < nhashes; ++i, g >>= 9)
+      {
+	unsigned bit = g % block_bits;
+	mask[bit / 64] |= word_type (1) << (bit % 64);
+      }
+
+    return ((h >> 32) * nblocks) >> 32;
+  }
+
+public:
+  bloom_filter (Hash const &hash = Hash ())
+    : _hash (hash)
+  {
+    clear ();
+  }
+
+  void
+  clear ()
+  {
+    for (size_type i = 0; i < nblocks; ++i)
+      std::fill (_blocks[i].words, _blocks[i].words + block_words,
+		 word_type (0));
+  }
+
+  void
+  swap (bloom_filter &other)
+  {
+    using std::swap;
+    swap (_blocks, other._blocks);
+    swap (_hash, other._hash);
+  }
+
+  void
+  insert (key_type const &key)
+  {
+    word_type mask[block_words];
+    block &blk = _blocks[locate (key, mask)];
+    for (size_type i = 0; i < block_words; ++i)
+      blk.words[i] |= mask[i];
+  }
+
+  // Answer false if KEY is certainly not in the filter, true if it
+  // might be.
+  bool
+  may_contain (key_type const &key) const
+  {
+    alignas (16) word_type mask[block_words];
+    block const &blk = _blocks[locate (key, mask)];
+
+#ifdef __SSE2__
+    __m128i missing = _mm_setzero_si128 ();
+    for (size_type i = 0; i < block_words; i += 2)
+      {
+	__m128i m = _mm_load_si128 ((__m128i const *)(mask + i));
+	__m128i b = _mm_loadu_si128 ((__m128i const *)(blk.words + i));
+	missing = _mm_or_si128 (missing, _mm_andnot_si128 (b, m));
+      }
+    __m128i zero = _mm_setzero_si128 ();
+    return _mm_movemask_epi8 (_mm_cmpeq_epi8 (missing, zero)) == 0xffff;
+#else
+    word_type missing = 0;
+    for (size_type i = 0; i < block_words; ++i)
+      missing |= mask[i] & ~blk.words[i];
+    return missing == 0;
+#endif
+  }
+};
+
+// A hashtab with a Bloom filter in front.  Lookups of keys that are
+// not in the table usually get answered by the filter, without
+// walking the probe chain.  That pays off when most lookups miss.
+template <class Key, class T, size_t N,
+	  class Hash1 = std::hash<Key>,
+	  class Hash2 = typename std::conditional<(N > 100),
+						  default_secondary_hash,
+						  trivial_secondary_hash>::type,
+	  class Equal = std::equal_to<Key>>
+class bloom_hashtab
+{
+  typedef hashtab<Key, T, N, Hash1, Hash2, Equal> table_type;
+  typedef bloom_filter<Key, N, Hash1> filter_type;
+
+  table_type _table;
+  filter_type _filter;
+
+public:
+  typedef typename table_type::key_type key_type;
+  typedef typename table_type::mapped_type mapped_type;
+  typedef typename table_type::value_type value_type;
+  typedef typename table_type::size_type size_type;
+  typedef typename table_type::reference reference;
+  typedef typename table_type::const_reference const_reference;
+  typedef typename table_type::pointer pointer;
+  typedef typename table_type::const_pointer const_pointer;
+  typedef typename table_type::iterator iterator;
+  typedef typename table_type::const_iterator const_iterator;
+
+  bloom_hashtab (Hash1 const &hash1 = Hash1 (),
+		 Hash2 const &hash2 = Hash2 (),
+		 Equal const &equal = Equal ())
+    : _table (hash1, hash2, equal)
+    , _filter (hash1)
+  {}
+
+  template <class InputIterator>
+  bloom_hashtab (InputIterator first, InputIterator last,
+		 Hash1 const &hash1 = Hash1 (),
+		 Hash2 const &hash2 = Hash2 (),
+		 Equal const &equal = Equal ())
+    : _table (hash1, hash2, equal)
+    , _filter (hash1)
+  {
+    insert (first, last);
+  }
+
+  void
+  swap (bloom_hashtab &other)
+  {
+    _table.swap (other._table);
+    _filter.swap (other._filter);
+  }
+
+  std::pair<iterator, bool>
+  insert (const_reference emt)
+  {
+    std::pair<iterator, bool> ret = _table.insert (emt);
+    if (ret.second)
+      _filter.insert (emt.first);
+    return ret;
+  }
+
+  iterator
+  insert (const_iterator, const_reference emt)
+  {
+    return insert (emt).first;
+  }
+
+  template <class InputIterator>
+  void
+  insert (InputIterator first, InputIterator last)
+  {
+    for (; first != last; ++first)
+      insert (*first);
+  }
+
+  const_iterator
+  find (key_type const &key) const
+  {
+    if (!_filter.may_contain (key))
+      return end ();
+    return _table.find (key);
+  }
+
+  iterator
+  find (key_type const &key)
+  {
+    if (!_filter.may_contain (key))
+      return end ();
+    return _table.find (key);
+  }
+
+  size_type
+  size () const
+  {
+    return _table.size ();
+  }
+
+  void
+  clear ()
+  {
+    _table.clear ();
+    _filter.clear ();
+  }
+
+  iterator
+  begin ()
+  {
+    return _table.begin ();
+  }
+
+  const_iterator
+  begin () const
+  {
+    return _table.begin ();
+  }
+
+  const_iterator
+  cbegin () const
+  {
+    return _table.cbegin ();
+  }
+
+  iterator
+  end ()
+  {
+    return _table.end ();
+  }
+
+  const_iterator
+  end () const
+  {
+    return _table.end ();
+  }
+
+  const_iterator
+  cend () const
+  {
+    return _table.cend ();
+  }
+
+  bool
+  operator == (bloom_hashtab const &other) const
+  {
+    return _table == other._table;
+  }
+
+  bool
+  operator != (bloom_hashtab const &other) const
+  {
+    return !(*this == other);
+  }
+};
+
+namespace std
+{
+  template <class Key, class T, size_t N, class Hash1, class Hash2,
+	    class Equal>
+  struct tuple_size<bloom_hashtab<Key, T, N, Hash1, Hash2, Equal>>
+  {
+    enum { value = N };
+  };
+}
+
+template <class Key, class T, size_t N, class Hash1, class Hash2,
+	  class Equal>
+void
+swap (bloom_hashtab<Key, T, N, Hash1, Hash2, Equal> &ht1,
+      bloom_hashtab<Key, T, N, Hash1, Hash2, Equal> &ht2)
+{
+  ht1.swap (ht2);
+}
+
+#endif /* _BLOOM_H_ */
@@ -0,0 +1,122 @@
+/*
+ * Test suite for fixed-size cache with CLOCK eviction.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cache.hh"
+#include "tests.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <string>
+
+template <class Key, int N>
+void
+tests ()
+{
+  typedef clock_cache<Key, int, N> C;
+  std::cout << std::endl << " + " << typeid (Key).name ()
+	    << " N=" << N << " capacity=" << C::capacity << " " << std::flush;
+
+  TestVector<N * 4, Key> const test;
+  C c;
+
+  std::cout << "0" << std::flush;
+  for (size_t i = 0; i < C::capacity; ++i)
+    assert (c.get (test[i]) == NULL);
+  assert (c.misses () == C::capacity);
+
+  // Fill up to capacity, nothing gets evicted.
+  std::cout << "1" << std::flush;
+  for (size_t i = 0; i < C::capacity; ++i)
+    c.put (test[i], i);
+  assert (c.size () == C::capacity);
+  assert (c.evictions () == 0);
+  for (size_t i = 0; i < C::capacity; ++i)
+    {
+      int *v = c.get (test[i]);
+      assert (v != NULL && *v == int (i));
+    }
+  assert (c.hits () == C::capacity);
+
+  // Putting an existing key updates it in place.
+  std::cout << "2" << std::flush;
+  c.put (test[0], -1);
+  assert (c.size () == C::capacity);
+  assert (*c.get (test[0]) == -1);
+
+  // Everything is referenced now.  The hand clears all the bits and
+  // comes around to evict something.
+  std::cout << "3" << std::flush;
+  c.put (test[C::capacity], 0);
+  assert (c.size () == C::capacity);
+  assert (c.evictions () == 1);
+  assert (c.find (test[C::capacity]) != c.end ());
+
+  // A working set that's looked up between insertions survives a
+  // stream of keys that are used just once.
+  std::cout << "4" << std::flush;
+  {
+    c.clear ();
+    size_t const hot = std::min (C::capacity / 2, size_t (100));
+    for (size_t i = 0; i < hot; ++i)
+      c.put (test[i], i);
+    for (size_t i = hot; i < test.size (); ++i)
+      {
+	for (size_t j = 0; j < hot; ++j)
+	  assert (c.get (test[j]) != NULL);
+	c.put (test[i], i);
+	assert (c.size () <= C::capacity);
+      }
+    for (size_t j = 0; j < hot; ++j)
+      {
+	int *v = c.get (test[j]);
+	assert (v != NULL && *v == int (j));
+      }
+  }
+
+  // With nothing ever looked up, the cache keeps taking new keys, and
+  // what it holds is all still findable after the rebuilds.
+  std::cout << "5" << std::flush;
+  {
+    c.clear ();
+    size_t before = c.evictions ();
+    for (size_t i = 0; i < test.size (); ++i)
+      c.put (test[i], i);
+    assert (c.size () == C::capacity);
+    assert (c.evictions () - before == test.size () - C::capacity);
+    assert (c.find (test.back ()) != c.end ());
+    size_t n = 0;
+    for (auto it = c.begin (); it != c.end (); ++it, ++n)
+      assert (*c.get (it->first) == it->second);
+    assert (n == C::capacity);
+  }
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::cout << "running clock_cache tests" << std::flush;
+  tests<int, 1> ();
+  tests<int, 17> ();
+  tests<int, 1021> ();
+  tests<int, 65521> ();
+  tests<std::string, 17> ();
+  tests<std::string, 1021> ();
+  std::cout << std::endl;
+}
@@ -0,0 +1,225 @@
+/*
+ * Implementation of fixed-size cache with CLOCK eviction on top of
+ * hashtab.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Each slot of the table has a reference bit, kept in a bitmap next
+ * to the occupancy bitmap.  A hit sets the bit.  When the cache is
+ * full, the clock hand sweeps the table, clearing set bits, until it
+ * finds an element whose bit is clear.  That element is evicted.
+ * The sweep goes a word at a time, so it usually skips 64 slots per
+ * step.
+ *
+ * New elements start with the bit clear, as in SIEVE, so elements
+ * that are never looked up again are the first to go.
+ *
+ * An evicted element leaves a tombstone behind.  A full table would
+ * leave no empty slots to end a lookup miss, so the cache holds at
+ * most seven eighths of N elements.  When the tombstones pile up,
+ * the table is rebuilt in place, and each element takes its
+ * reference bit along to its new slot.  */
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+#include "hash.hh"
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+template <class Key, class T, size_t N,
+	  class Hash1 = std::hash<Key>,
+	  class Hash2 = typename std::conditional<(N > 100),
+						  default_secondary_hash,
+						  trivial_secondary_hash>::type,
+	  class Equal = std::equal_to<Key>>
+class clock_cache
+  : private hashtab<Key, T, N, Hash1, Hash2, Equal>
+{
+  typedef hashtab<Key, T, N, Hash1, Hash2, Equal> Super;
+  typedef typename Super::bitmap bitmap;
+  typedef typename bitmap::word_type word_type;
+
+public:
+  typedef typename Super::key_type key_type;
+  typedef typename Super::mapped_type mapped_type;
+  typedef typename Super::value_type value_type;
+  typedef typename Super::size_type size_type;
+  typedef typename Super::reference reference;
+  typedef typename Super::const_reference const_reference;
+  typedef typename Super::iterator iterator;
+  typedef typename Super::const_iterator const_iterator;
+
+  static const size_type capacity = N > 8 ? N - N / 8 : N;
+
+private:
+  bitmap _referenced;
+  size_type _hand;
+  size_type _hits;
+  size_type _misses;
+  size_type _evictions;
+
+  // Move the hand to the next element with a clear reference bit,
+  // clearing the bits on the way, and answer its position.  There
+  // has to be at least one element.
+  size_type
+  advance_hand ()
+  {
+    for (;;)
+      {
+	size_type w = _hand / bitmap::word_bits;
+	word_type ahead = ~word_type (0) << (_hand % bitmap::word_bits);
+	word_type victims = this->_taken.words[w] & ~_referenced.words[w] & ahead;
+	if (victims != 0)
+	  {
+	    size_type bit = __builtin_ctzll (victims);
+	    word_type passed = ahead & ((word_type (1) << bit) - 1);
+	    _referenced.words[w] &= ~passed;
+	    size_type pos = w * bitmap::word_bits + bit;
+	    _hand = pos + 1 < N ? pos + 1 : 0;
+	    return pos;
+	  }
+
+	// Second chance for everyone in the rest of this word.
+	_referenced.words[w] &= ~ahead;
+	_hand = (w + 1) * bitmap::word_bits;
+	if (_hand >= N)
+	  _hand = 0;
+      }
+  }
+
+  void
+  evict ()
+  {
+    size_type pos = advance_hand ();
+    this->remove_slot (pos);
+    _referenced.reset (pos);
+    ++_evictions;
+  }
+
+public:
+  clock_cache (Hash1 const &hash1 = Hash1 (),
+	       Hash2 const &hash2 = Hash2 (),
+	       Equal const &equal = Equal ())
+    : Super (hash1, hash2, equal)
+    , _hand (0)
+    , _hits (0)
+    , _misses (0)
+    , _evictions (0)
+  {}
+
+  // Look up KEY.  Answer a pointer to its value, or NULL if it's not
+  // cached.
+  mapped_type *
+  get (key_type const &key)
+  {
+    bool found;
+    size_type pos = this->find_pos (key, found);
+    if (!found)
+      {
+	++_misses;
+	return NULL;
+      }
+
+    ++_hits;
+    _referenced.set (pos);
+    return &this->tab (pos).second;
+  }
+
+  // Cache VALUE under KEY, replacing the previous value if there was
+  // one, and evicting another element if the cache is full.
+  void
+  put (key_type const &key, mapped_type const &value)
+  {
+    bool found;
+    size_type pos = this->find_pos (key, found);
+    if (found)
+      {
+	this->tab (pos).second = value;
+	_referenced.set (pos);
+	return;
+      }
+
+    if (this->size () == capacity)
+      evict ();
+    Super::insert (std::make_pair (key, value));
+
+    if (this->too_many_tombstones ())
+      {
+	bool carried = false;
+	this->rebuild ([this, &carried] (size_type pos)
+		       {
+			 bool was = _referenced[pos];
+			 if (carried)
+			   _referenced.set (pos);
+			 else
+			   _referenced.reset (pos);
+			 carried = was;
+		       });
+	_hand = 0;
+      }
+  }
+
+  void
+  put (const_reference emt)
+  {
+    put (emt.first, emt.second);
+  }
+
+  // Like get, but doesn't count as a use.
+  const_iterator
+  find (key_type const &key) const
+  {
+    return Super::find (key);
+  }
+
+  void
+  clear ()
+  {
+    Super::clear ();
+    _referenced.clear ();
+    _hand = 0;
+  }
+
+  size_type
+  hits () const
+  {
+    return _hits;
+  }
+
+  size_type
+  misses () const
+  {
+    return _misses;
+  }
+
+  size_type
+  evictions () const
+  {
+    return _evictions;
+  }
+
+  using Super::size;
+  using Super::begin;
+  using Super::end;
+  using Super::cbegin;
+  using Super::cend;
+};
+
+#endif /* _CACHE_H_ */
@@ -0,0 +1,558 @@
+/*
+ * Implementation of growable singly linked list with index links.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Like slist, but the slots live on the heap, in chunks of ChunkSize
+ * slots with their links.  When all slots are taken, another chunk
+ * is allocated.  Chunks never move, so elements keep both their
+ * addresses and their indices for as long as they are in the list.
+ * The list object itself is small, and swap and move are O(1).
+ *
+ * The capacity is limited by MaxN, which also determines the width of
+ * the links: index_type_for<MaxN>, so e.g. a list that will never
+ * hold more than 65535 elements can use 16-bit links.  */
+
+#ifndef _CHUNKED_SLIST_H_
+#define _CHUNKED_SLIST_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "index_type.hh"
+
+template<class T, size_t ChunkSize = 256, size_t MaxN = 4294967295ULL>
+class chunked_slist
+{
+  static_assert ((ChunkSize & (ChunkSize - 1)) == 0,
+		 "ChunkSize has to be a power of two");
+
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef value_type &reference;
+  typedef const value_type &const_reference;
+  typedef value_type *pointer;
+  typedef const value_type *const_pointer;
+
+protected:
+  // MaxN marks the end of a chain.
+  typedef typename index_type_for<MaxN>::type index_type;
+  static const index_type nil = MaxN;
+
+  struct alignas (T) slot
+  {
+    unsigned char bytes[sizeof (T)]; // payload
+  };
+
+  struct chunk
+  {
+    slot slots[ChunkSize];
+    index_type nexts[ChunkSize];
+  };
+
+  std::vector<std::unique_ptr<chunk>> _chunks;
+  index_type _head;
+  index_type _free;
+  // Slots from _bump up have never been used.
+  size_type _bump;
+
+  chunk &
+  chunk_of (size_type i) const
+  {
+    return *_chunks[i / ChunkSize];
+  }
+
+  index_type &
+  next (size_type i)
+  {
+    return chunk_of (i).nexts[i % ChunkSize];
+  }
+
+  index_type
+  next (size_type i) const
+  {
+    return chunk_of (i).nexts[i % ChunkSize];
+  }
+
+  reference
+  payload (size_type i)
+  {
+    return *reinterpret_cast<pointer> (chunk_of (i).slots[i % ChunkSize].bytes);
+  }
+
+  const_reference
+  payload (size_type i) const
+  {
+    return *reinterpret_cast<const_pointer>
+      (chunk_of (i).slots[i % ChunkSize].bytes);
+  }
+
+  template<class This, class List>
+  class iterator_builder
+    : public std::iterator<std::forward_iterator_tag, T>
+  {
+  protected:
+    List _parent;
+    index_type _pos;
+
+    iterator_builder (List parent, index_type pos)
+      : _parent (parent)
+      , _pos (pos)
+    {}
+
+  public:
+    bool
+    operator == (This const &other) const
+    {
+      return _pos == other._pos;
+    }
+
+    bool
+    operator != (This const &other) const
+    {
+      return !(*this == other);
+    }
+
+    This &
+    operator ++ ()
+    {
+      assert (_pos != nil);
+      _pos = _parent->next (_pos);
+      return *(This *)this;
+    }
+
+    This
+    operator ++ (int)
+    {
+      This copy = *(This *)this;
+      ++*this;
+      return copy;
+    }
+  };
+
+public:
+  class iterator
+    : public iterator_builder<iterator, chunked_slist *>
+  {
+    typedef iterator_builder<iterator, chunked_slist *> Super;
+    friend class chunked_slist;
+
+    iterator (chunked_slist *parent, index_type pos)
+      : Super (parent, pos)
+    {}
+
+  public:
+    iterator ()
+      : Super (NULL, nil)
+    {}
+
+    reference
+    operator * () const
+    {
+      return this->_parent->payload (this->_pos);
+    }
+
+    pointer
+    operator -> () const
+    {
+      return &**this;
+    }
+  };
+
+  class const_iterator
+    : public iterator_builder<const_iterator, chunked_slist const *>
+  {
+    typedef iterator_builder<const_iterator, chunked_slist const *> Super;
+    friend class chunked_slist;
+
+    const_iterator (chunked_slist const *parent, index_type pos)
+      : Super (parent, pos)
+    {}
+
+  public:
+    const_iterator ()
+      : Super (NULL, nil)
+    {}
+
+    const_iterator (iterator const &other)
+      : Super (other._parent, other._pos)
+    {}
+
+    const_reference
+    operator * () const
+    {
+      return this->_parent->payload (this->_pos);
+    }
+
+    const_pointer
+    operator -> () const
+    {
+      return &**this;
+    }
+  };
+
+private:
+  typedef std::integral_constant<bool, std::is_trivially_copyable<T>::value>
+  trivial_copy;
+
+  void
+  init ()
+  {
+    _head = nil;
+    _free = nil;
+    _bump = 0;
+  }
+
+  void
+  push_back (const T &value, index_type &tail)
+  {
+    index_type i = take_slot (value);
+    next (i) = nil;
+    if (tail != nil)
+      next (tail) = i;
+    else
+      _head = i;
+    tail = i;
+  }
+
+  void
+  clone_chunks (chunked_slist const &copy, std::true_type)
+  {
+    for (size_type c = 0; c < copy._chunks.size (); ++c)
+      std::memcpy (_chunks[c].get (), copy._chunks[c].get (), sizeof (chunk));
+  }
+
+  void
+  clone_chunks (chunked_slist const &copy, std::false_type)
+  {
+    for (size_type c = 0; c < copy._chunks.size (); ++c)
+      std::memcpy (_chunks[c]->nexts, copy._chunks[c]->nexts,
+		   sizeof (_chunks[c]->nexts));
+    for (index_type i = _head; i != nil; i = next (i))
+      new (chunk_of (i).slots[i % ChunkSize].bytes) T (copy.payload (i));
+  }
+
+  template <class... Args>
+  index_type
+  take_slot (Args &&... args)
+  {
+    index_type i;
+    if (_free != nil)
+      i = _free;
+    else
+      {
+	if (_bump == MaxN)
+	  throw std::bad_alloc ();
+	if (_bump == _chunks.size () * ChunkSize)
+	  _chunks.push_back (std::unique_ptr<chunk> (new chunk));
+	i = _bump;
+      }
+
+    new (chunk_of (i).slots[i % ChunkSize].bytes)
+      T (std::forward<Args> (args)...);
+    if (i == _free)
+      _free = next (i);
+    else
+      ++_bump;
+    return i;
+  }
+
+  void
+  return_slot (index_type i)
+  {
+    payload (i).~T ();
+    next (i) = _free;
+    _free = i;
+  }
+
+public:
+  chunked_slist ()
+  {
+    init ();
+  }
+
+  // Keep each element at the index it has in COPY.
+  chunked_slist (chunked_slist const &copy)
+    : _head (copy._head)
+    , _free (copy._free)
+    , _bump (copy._bump)
+  {
+    for (size_type c = 0; c < copy._chunks.size (); ++c)
+      _chunks.push_back (std::unique_ptr<chunk> (new chunk));
+    clone_chunks (copy, trivial_copy ());
+  }
+
+  chunked_slist (chunked_slist &&other)
+  {
+    init ();
+    swap (other);
+  }
+
+  template <class InputIterator>
+  chunked_slist (InputIterator first, InputIterator last)
+  {
+    init ();
+    index_type tail = nil;
+    while (first != last)
+      push_back (*first++, tail);
+  }
+
+  chunked_slist (size_t n, T const &value = T ())
+  {
+    init ();
+    for (size_t i = 0; i < n; ++i)
+      push_front (value);
+  }
+
+  ~chunked_slist ()
+  {
+    if (!std::is_trivially_destructible<T>::value)
+      for (auto it = begin (); it != end (); ++it)
+	it->~T ();
+  }
+
+  void
+  swap (chunked_slist &other)
+  {
+    std::swap (_chunks, other._chunks);
+    std::swap (_head, other._head);
+    std::swap (_free, other._free);
+    std::swap (_bump, other._bump);
+  }
+
+  chunked_slist &
+  operator = (chunked_slist other)
+  {
+    swap (other);
+    return *this;
+  }
+
+  // Chunks are kept for reuse.
+  void
+  clear ()
+  {
+    if (!std::is_trivially_destructible<T>::value)
+      for (auto it = begin (); it != end (); ++it)
+	it->~T ();
+    init ();
+  }
+
+  // Make room for N elements without further allocation.
+  void
+  reserve (size_type n)
+  {
+    while (_chunks.size () * ChunkSize < n)
+      _chunks.push_back (std::unique_ptr<chunk> (new chunk));
+  }
+
+  void
+  resize (size_t n, T const &value = T ())
+  {
+    if (n == 0)
+      {
+	clear ();
+	return;
+      }
+
+    iterator it = begin ();
+    iterator jt = it;
+    size_t i = 0;
+    for (; i < n - 1; ++i)
+      if (it == end ())
+	break;
+      else
+	jt = it++;
+    if (it != end ())
+      erase_after (it, end ());
+    else
+      for (; i < n; ++i)
+	insert_after (jt, value);
+  }
+
+  template <class... Args>
+  void
+  emplace_front (Args &&... args)
+  {
+    index_type i = take_slot (std::forward<Args> (args)...);
+    next (i) = _head;
+    _head = i;
+  }
+
+  void
+  push_front (const T &value)
+  {
+    emplace_front (value);
+  }
+
+  void
+  push_front (T &&value)
+  {
+    emplace_front (std::move (value));
+  }
+
+  template <class... Args>
+  iterator
+  emplace_after (const_iterator it, Args &&... args)
+  {
+    assert (it._pos != nil);
+    index_type i = take_slot (std::forward<Args> (args)...);
+    next (i) = next (it._pos);
+    next (it._pos) = i;
+    return iterator (this, i);
+  }
+
+  void
+  insert_after (const_iterator it, const T &value)
+  {
+    emplace_after (it, value);
+  }
+
+  void
+  insert_after (const_iterator it, T &&value)
+  {
+    emplace_after (it, std::move (value));
+  }
+
+  void
+  pop_front ()
+  {
+    index_type i = _head;
+    _head = next (i);
+    return_slot (i);
+  }
+
+  iterator
+  erase_after (const_iterator it)
+  {
+    index_type n = next (it._pos);
+    index_type nn = next (n);
+    next (it._pos) = nn;
+    return_slot (n);
+    return iterator (this, nn);
+  }
+
+  iterator
+  erase_after (const_iterator first, const_iterator last)
+  {
+    while (next (first._pos) != last._pos)
+      erase_after (first);
+    return iterator (this, last._pos);
+  }
+
+  reference
+  front ()
+  {
+    return *begin ();
+  }
+
+  const_reference
+  front () const
+  {
+    return *begin ();
+  }
+
+  bool
+  empty () const
+  {
+    return _head == nil;
+  }
+
+  // Answer the number of slots allocated so far.
+  size_type
+  capacity () const
+  {
+    return _chunks.size () * ChunkSize;
+  }
+
+  size_type
+  max_size () const
+  {
+    return MaxN;
+  }
+
+  iterator
+  begin ()
+  {
+    return iterator (this, _head);
+  }
+
+  const_iterator
+  begin () const
+  {
+    return const_iterator (this, _head);
+  }
+
+  const_iterator
+  cbegin () const
+  {
+    return begin ();
+  }
+
+  iterator
+  end ()
+  {
+    return iterator (this, nil);
+  }
+
+  const_iterator
+  end () const
+  {
+    return const_iterator (this, nil);
+  }
+
+  const_iterator
+  cend () const
+  {
+    return end ();
+  }
+
+  bool
+  operator == (chunked_slist const &other) const
+  {
+    const_iterator it = begin ();
+    const_iterator jt = other.begin ();
+    for (; it != end () && jt != other.end (); ++it, ++jt)
+      if (*it != *jt)
+	return false;
+    return (it == end ()) == (jt == other.end ());
+  }
+
+  bool
+  operator != (chunked_slist const &other) const
+  {
+    return !(*this == other);
+  }
+};
+
+template<class T, size_t ChunkSize, size_t MaxN>
+void
+swap (chunked_slist<T, ChunkSize, MaxN> &l1,
+      chunked_slist<T, ChunkSize, MaxN> &l2)
+{
+  l1.swap (l2);
+}
+
+#endif /* _CHUNKED_SLIST_H_ */
@@ -0,0 +1,399 @@
+/*
+ * Implementation of fixed-size hash table with a compact index and
+ * elements kept in insertion order.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The layout of CPython's dict.  The hash table proper holds only
+ * small integers, as narrow as N allows, and these point into an
+ * array of elements that is filled from the front in insertion
+ * order.  Empty slots thus cost a byte or two instead of a whole
+ * value_type, and iteration is a sequential scan over exactly
+ * size() elements, in a deterministic order.  Iterators are plain
+ * pointers.
+ *
+ * The price is one more indirection per probe.  Lookups compare the
+ * key only after going through the index, so with large elements,
+ * the index stays in cache and the probes touch less memory than
+ * hashtab's do.
+ *
+ * Probing is the same double hashing that hashtab uses.  There's no
+ * removal, which would leave holes in the element array.  */
+
+#ifndef _DENSE_HASH_H_
+#define _DENSE_HASH_H_
+
+#include "hash.hh"
+#include "index_type.hh"
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+template <class Key, class T, size_t N,
+	  class Hash1 = std::hash<Key>,
+	  class Hash2 = typename std::conditional<(N > 100),
+						  default_secondary_hash,
+						  trivial_secondary_hash>::type,
+	  class Equal = std::equal_to<Key>>
+class dense_hashtab
+{
+public:
+  typedef Key key_type;
+  typedef T mapped_type;
+  typedef std::pair<key_type, mapped_type> value_type;
+  typedef size_t size_type;
+  typedef Hash1 primary_hasher;
+  typedef Hash2 secondary_hasher;
+  typedef Equal key_equal;
+  typedef value_type &reference;
+  typedef value_type const &const_reference;
+  typedef value_type *pointer;
+  typedef value_type const *const_pointer;
+  typedef pointer iterator;
+  typedef const_pointer const_iterator;
+
+private:
+  // N marks an empty index slot.
+  typedef typename index_type_for<N>::type index_type;
+
+  // Unlike in hashtab, the payload follows the index, which may have
+  // an odd size.
+  struct alignas (value_type) slot
+  {
+    unsigned char bytes[sizeof (value_type)]; // payload
+  };
+
+  typedef std::integral_constant
+    <bool, (std::is_trivially_copyable<Key>::value
+	    && std::is_trivially_copyable<T>::value)> trivial_copy;
+
+  index_type _index[N];
+  slot _entries[N];
+  size_type _size;
+
+  primary_hasher _hash1;
+  secondary_hasher _hash2;
+  key_equal _eq;
+
+  value_type const &
+  entry (size_type i) const
+  {
+    return *reinterpret_cast<const_pointer> (_entries[i].bytes);
+  }
+
+  value_type &
+  entry (size_type i)
+  {
+    return *reinterpret_cast<pointer> (_entries[i].bytes);
+  }
+
+  // Find the index slot that points to E, or else the empty slot
+  // where a pointer to E should go.  The latter is N if there's no
+  // room at all.
+  size_type
+  find_slot (key_type const &e, bool &found, size_type &probes) const
+  {
+    size_type pos = _hash1 (e) % N;
+    size_type d = _hash2 (pos);
+    found = false;
+    for (probes = 1; ; pos = (pos + d) % N, ++probes)
+      {
+	size_type i = _index[pos];
+	if (i == N)
+	  return pos;
+	if (_eq (entry (i).first, e))
+	  {
+	    found = true;
+	    return pos;
+	  }
+	if (probes == N)
+	  return N;
+      }
+  }
+
+  size_type
+  find_slot (key_type const &e, bool &found) const
+  {
+    size_type probes;
+    return find_slot (e, found, probes);
+  }
+
+  void
+  clone_entries (dense_hashtab const &copy, std::true_type)
+  {
+    std::memcpy (_entries, copy._entries, _size * sizeof (slot));
+  }
+
+  void
+  clone_entries (dense_hashtab const &copy, std::false_type)
+  {
+    for (size_type i = 0; i < _size; ++i)
+      new (&_entries[i]) value_type (copy.entry (i));
+  }
+
+  void
+  swap_entries (dense_hashtab &other, std::true_type)
+  {
+    size_type n = std::max (_size, other._size);
+    std::swap_ranges (_entries, _entries + n, other._entries);
+  }
+
+  // Swap the elements both tables have and move the rest over to the
+  // shorter side.
+  void
+  swap_entries (dense_hashtab &other, std::false_type)
+  {
+    using std::swap;
+    size_type common = std::min (_size, other._size);
+    for (size_type i = 0; i < common; ++i)
+      swap (entry (i), other.entry (i));
+
+    dense_hashtab &longer = _size > other._size ? *this : other;
+    dense_hashtab &shorter = _size > other._size ? other : *this;
+    for (size_type i = common; i < longer._size; ++i)
+      {
+	new (&shorter._entries[i]) value_type (std::move (longer.entry (i)));
+	longer.entry (i).~value_type ();
+      }
+  }
+
+public:
+  dense_hashtab (Hash1 const &hash1 = Hash1 (),
+		 Hash2 const &hash2 = Hash2 (),
+		 Equal const &equal = Equal ())
+    : _size (0)
+    , _hash1 (hash1)
+    , _hash2 (hash2)
+    , _eq (equal)
+  {
+    std::fill (_index, _index + N, index_type (N));
+  }
+
+  // The copy has the same N and the same hashers, so the index can
+  // be cloned as it is.
+  dense_hashtab (dense_hashtab const &copy)
+    : _size (copy._size)
+    , _hash1 (copy._hash1)
+    , _hash2 (copy._hash2)
+    , _eq (copy._eq)
+  {
+    std::memcpy (_index, copy._index, sizeof (_index));
+    clone_entries (copy, trivial_copy ());
+  }
+
+  dense_hashtab (std::initializer_list<value_type> init,
+		 Hash1 const &hash1 = Hash1 (),
+		 Hash2 const &hash2 = Hash2 (),
+		 Equal const &equal = Equal ())
+    : dense_hashtab (hash1, hash2, equal)
+  {
+    insert (init.begin (), init.end ());
+  }
+
+  template <class InputIterator>
+  dense_hashtab (InputIterator first, InputIterator last,
+		 Hash1 const &hash1 = Hash1 (),
+		 Hash2 const &hash2 = Hash2 (),
+		 Equal const &equal = Equal ())
+    : dense_hashtab (hash1, hash2, equal)
+  {
+    insert (first, last);
+  }
+
+  ~dense_hashtab ()
+  {
+    if (!std::is_trivially_destructible<value_type>::value)
+      for (size_type i = 0; i < _size; ++i)
+	entry (i).~value_type ();
+  }
+
+  void
+  swap (dense_hashtab &other)
+  {
+    using std::swap;
+    if (this == &other)
+      return;
+    swap_entries (other, trivial_copy ());
+    swap (_index, other._index);
+    swap (_size, other._size);
+    swap (_hash1, other._hash1);
+    swap (_hash2, other._hash2);
+    swap (_eq, other._eq);
+  }
+
+  dense_hashtab &
+  operator = (dense_hashtab other)
+  {
+    swap (other);
+    return *this;
+  }
+
+  bool
+  operator == (dense_hashtab const &other) const
+  {
+    if (_size != other._size)
+      return false;
+    for (const_iterator it = begin (); it != end (); ++it)
+      {
+	const_iterator jt = other.find (it->first);
+	if (jt == other.end () || !(jt->second == it->second))
+	  return false;
+      }
+    return true;
+  }
+
+  bool
+  operator != (dense_hashtab const &other) const
+  {
+    return !(*this == other);
+  }
+
+  std::pair<iterator, bool>
+  insert (const_reference emt)
+  {
+    bool found;
+    size_type pos = find_slot (emt.first, found);
+    if (found)
+      return std::make_pair (begin () + _index[pos], false);
+    if (pos == N)
+      return std::make_pair (end (), false);
+
+    new (&_entries[_size]) value_type (emt);
+    _index[pos] = index_type (_size);
+    return std::make_pair (begin () + _size++, true);
+  }
+
+  iterator
+  insert (const_iterator, const_reference emt)
+  {
+    return insert (emt).first;
+  }
+
+  template <class InputIterator>
+  void
+  insert (InputIterator first, InputIterator last)
+  {
+    for (; first != last; ++first)
+      insert (*first);
+  }
+
+  const_iterator
+  find (key_type const &e) const
+  {
+    bool found;
+    size_type pos = find_slot (e, found);
+    return found ? begin () + _index[pos] : end ();
+  }
+
+  iterator
+  find (key_type const &e)
+  {
+    return const_cast<iterator>
+      (const_cast<dense_hashtab const *> (this)->find (e));
+  }
+
+  primary_hasher
+  hash_function () const
+  {
+    return _hash1;
+  }
+
+  // Answer how many index slots a lookup of E examines.
+  size_type
+  probe_count (key_type const &e) const
+  {
+    bool found;
+    size_type probes;
+    find_slot (e, found, probes);
+    return probes;
+  }
+
+  size_type
+  size () const
+  {
+    return _size;
+  }
+
+  void
+  clear ()
+  {
+    *this = dense_hashtab (_hash1, _hash2, _eq);
+  }
+
+  iterator
+  begin ()
+  {
+    return reinterpret_cast<pointer> (_entries[0].bytes);
+  }
+
+  const_iterator
+  begin () const
+  {
+    return reinterpret_cast<const_pointer> (_entries[0].bytes);
+  }
+
+  const_iterator
+  cbegin () const
+  {
+    return begin ();
+  }
+
+  iterator
+  end ()
+  {
+    return begin () + _size;
+  }
+
+  const_iterator
+  end () const
+  {
+    return begin () + _size;
+  }
+
+  const_iterator
+  cend () const
+  {
+    return end ();
+  }
+};
+
+namespace std
+{
+  template <class Key, class T, size_t N, class Hash1, class Hash2,
+	    class Equal>
+  struct tuple_size<dense_hashtab<Key, T, N, Hash1, Hash2, Equal>>
+  {
+    enum { value = N };
+  };
+}
+
+template <class Key, class T, size_t N, class Hash1, class Hash2,
+	  class Equal>
+void
+swap (dense_hashtab<Key, T, N, Hash1, Hash2, Equal> &ht1,
+      dense_hashtab<Key, T, N, Hash1, Hash2, Equal> &ht2)
+{
+  ht1.swap (ht2);
+}
+
+#endif /* _DENSE_HASH_H_ */
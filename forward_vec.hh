@@ -21,13 +21,25 @@
 #ifndef _FORWARD_VEC_H_
 #define _FORWARD_VEC_H_
 
+#include <algorithm>
+#include <memory>
+#include <type_traits>
 #include <vector>
 
-template <class T, class Allocator = std::allocator<T>>
+// The elements are kept backwards in Container, which has to have the
+// interface of std::vector.  With small_vec, short lists don't
+// allocate at all.  Allocator only applies to the default Container;
+// a custom Container brings its own.
+template <class T, class Allocator = std::allocator<T>,
+	  class Container = std::vector<T, Allocator>>
 class forward_vec
-  : private std::vector<T, Allocator>
+  : private Container
 {
-  typedef std::vector<T, Allocator> Super;
+  static_assert (std::is_same<Container, std::vector<T, Allocator>>::value
+		 || std::is_same<Allocator, std::allocator<T>>::value,
+		 "Allocator is ignored with a custom Container");
+
+  typedef Container Super;
 public:
   typedef typename Super::reverse_iterator iterator;
   typedef typename Super::const_reverse_iterator const_iterator;
@@ -125,6 +137,7 @@ private:
   }
 
 public:
+  // Answer the element after the erased one.
   iterator
   erase_after (const_iterator it)
   {
@@ -132,7 +145,7 @@ public:
     auto jt = underlying_iter (it, i) - 1;
     if (it + 1 < end ())
       Super::erase (jt);
-    return begin () + i;
+    return begin () + (i + 1);
   }
 
   iterator
@@ -141,46 +154,65 @@ public:
     return erase_after (this->cbegin () + (it - this->begin ()));
   }
 
+  // Erase the elements between FIRST and LAST with a single erase on
+  // the vector.  Answer LAST.
   iterator
   erase_after (const_iterator first, const_iterator last)
   {
     size_type a = first - this->cbegin ();
-    for (size_type count = last - first; count > 0; --count)
-      erase_after (this->cbegin () + a);
-    return this->begin () + a;
+    size_type b = last - this->cbegin ();
+    if (b > a + 1)
+      {
+	size_type n = this->size ();
+	Super::erase (Super::begin () + (n - b), Super::begin () + (n - 1 - a));
+      }
+    return this->begin () + (a + 1);
   }
 
-  void
+  iterator
   insert_after (const_iterator it, const T &value)
   {
     size_type i;
     auto jt = underlying_iter (it, i);
     Super::insert (jt, value);
+    return begin () + (i + 1);
+  }
+
+  // The vector keeps the elements backwards, so insert them with a
+  // single insert and reverse them in place.  Answer the last
+  // inserted element.
+  template <class InputIterator>
+  iterator
+  insert_after (const_iterator it, InputIterator first, InputIterator last)
+  {
+    size_type i;
+    size_type ri = underlying_iter (it, i) - Super::begin ();
+    size_type n = this->size ();
+    Super::insert (Super::begin () + ri, first, last);
+    size_type count = this->size () - n;
+    std::reverse (Super::begin () + ri, Super::begin () + ri + count);
+    return begin () + (i + count);
   }
 
+  iterator
+  insert_after (const_iterator it, size_type count, const T &value)
+  {
+    size_type i;
+    auto jt = underlying_iter (it, i);
+    Super::insert (jt, count, value);
+    return begin () + (i + count);
+  }
+
+  // The end of the list is the front of the vector, so this is a
+  // single erase or insert there.
   void
   resize (size_type n, T const &value = T ())
   {
-    // taken from slist.hh
-    if (n == 0)
-      {
-	clear ();
-	return;
-      }
-
-    iterator it = begin ();
-    iterator jt = it;
-    size_type i = 0;
-    for (; i < n - 1; ++i)
-      if (it == end ())
-	break;
-      else
-	jt = it++;
-    if (it != end ())
-      erase_after (it, end ());
+    size_type size = this->size ();
+    if (n < size)
+      Super::erase (Super::begin (), Super::begin () + (size - n));
     else
-      for (; i < n; ++i)
-	insert_after (jt, value);
+      Super::insert (Super::begin (), n - size, value);
   }
 };
 
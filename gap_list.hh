@@ -0,0 +1,561 @@
+/*
+ * Implementation of singly linked list interface on top of a gap
+ * buffer.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Like forward_vec, the elements are stored in list order in one
+ * buffer, but the free space of the buffer is a gap that stays where
+ * the last edit was.  An edit first moves the gap to the edited
+ * position, which costs as many element moves as the gap travels,
+ * and then takes or returns one slot at the edge of the gap.  So a
+ * series of edits around one cursor is O(1) each, and iteration is a
+ * walk over two contiguous runs.
+ *
+ * insert_after fills the gap from its front, so that the gap follows
+ * a cursor that inserts and then moves on to the new element.
+ * push_front fills it from its back, so that repeated push_front
+ * doesn't move anything.
+ *
+ * Any edit invalidates all iterators.  */
+
+#ifndef _GAP_LIST_H_
+#define _GAP_LIST_H_
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <class T>
+class gap_list
+{
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef value_type &reference;
+  typedef const value_type &const_reference;
+  typedef value_type *pointer;
+  typedef const value_type *const_pointer;
+
+private:
+  struct alignas (T) slot
+  {
+    unsigned char bytes[sizeof (T)]; // payload
+  };
+
+  std::unique_ptr<slot[]> _slots;
+  size_type _capacity;
+  // Slots from _gap_begin up to _gap_end are free.
+  size_type _gap_begin;
+  size_type _gap_end;
+
+  reference
+  payload (size_type i)
+  {
+    return *reinterpret_cast<pointer> (_slots[i].bytes);
+  }
+
+  const_reference
+  payload (size_type i) const
+  {
+    return *reinterpret_cast<const_pointer> (_slots[i].bytes);
+  }
+
+  // Move the payload of slot I to the free slot J.
+  void
+  relocate (size_type i, slot *to, size_type j)
+  {
+    new (to[j].bytes) T (std::move (payload (i)));
+    payload (i).~T ();
+  }
+
+  template<class This, class Ptr>
+  class iterator_builder
+    : public std::iterator<std::forward_iterator_tag, T>
+  {
+  protected:
+    // The gap is skipped over.
+    Ptr _p;
+    Ptr _gap_begin;
+    Ptr _gap_end;
+
+    iterator_builder (Ptr p, Ptr gap_begin, Ptr gap_end)
+      : _p (p == gap_begin ? gap_end : p)
+      , _gap_begin (gap_begin)
+      , _gap_end (gap_end)
+    {}
+
+  public:
+    bool
+    operator == (This const &other) const
+    {
+      return _p == other._p;
+    }
+
+    bool
+    operator != (This const &other) const
+    {
+      return !(*this == other);
+    }
+
+    This &
+    operator ++ ()
+    {
+      if (++_p == _gap_begin)
+	_p = _gap_end;
+      return *(This *)this;
+    }
+
+    This
+    operator ++ (int)
+    {
+      This copy = *(This *)this;
+      ++*this;
+      return copy;
+    }
+  };
+
+public:
+  class iterator
+    : public iterator_builder<iterator, pointer>
+  {
+    typedef iterator_builder<iterator, pointer> Super;
+    friend class gap_list;
+
+    iterator (pointer p, pointer gap_begin, pointer gap_end)
+      : Super (p, gap_begin, gap_end)
+    {}
+
+  public:
+    iterator ()
+      : Super (NULL, NULL, NULL)
+    {}
+
+    reference
+    operator * () const
+    {
+      return *this->_p;
+    }
+
+    pointer
+    operator -> () const
+    {
+      return this->_p;
+    }
+  };
+
+  class const_iterator
+    : public iterator_builder<const_iterator, const_pointer>
+  {
+    typedef iterator_builder<const_iterator, const_pointer> Super;
+    friend class gap_list;
+
+    const_iterator (const_pointer p, const_pointer gap_begin,
+		    const_pointer gap_end)
+      : Super (p, gap_begin, gap_end)
+    {}
+
+  public:
+    const_iterator ()
+      : Super (NULL, NULL, NULL)
+    {}
+
+    const_iterator (iterator const &other)
+      : Super (other._p, other._gap_begin, other._gap_end)
+    {}
+
+    const_reference
+    operator * () const
+    {
+      return *this->_p;
+    }
+
+    const_pointer
+    operator -> () const
+    {
+      return this->_p;
+    }
+  };
+
+private:
+  pointer
+  at (size_type i)
+  {
+    return reinterpret_cast<pointer> (_slots.get () + i);
+  }
+
+  const_pointer
+  at (size_type i) const
+  {
+    return reinterpret_cast<const_pointer> (_slots.get () + i);
+  }
+
+  iterator
+  iter (size_type i)
+  {
+    return iterator (at (i), at (_gap_begin), at (_gap_end));
+  }
+
+  // Answer the position in the list of the element at IT.
+  size_type
+  index_of (const_iterator it) const
+  {
+    size_type i = it._p - at (0);
+    return i < _gap_begin ? i : i - (_gap_end - _gap_begin);
+  }
+
+  // Make the gap start at position I of the list.
+  void
+  move_gap (size_type i)
+  {
+    if (_gap_begin == _gap_end)
+      _gap_begin = _gap_end = i;
+    else if (i < _gap_begin)
+      {
+	size_type d = _gap_begin - i;
+	for (size_type k = d; k-- > 0; )
+	  relocate (i + k, _slots.get (), _gap_end - d + k);
+	_gap_begin -= d;
+	_gap_end -= d;
+      }
+    else if (i > _gap_begin)
+      {
+	size_type d = i - _gap_begin;
+	for (size_type k = 0; k < d; ++k)
+	  relocate (_gap_end + k, _slots.get (), _gap_begin + k);
+	_gap_begin += d;
+	_gap_end += d;
+      }
+  }
+
+  // Answer whether opening a slot at position I of the list leaves
+  // the elements where they are.
+  bool
+  room_at (size_type i) const
+  {
+    return empty () || (_gap_begin == i && _gap_begin < _gap_end);
+  }
+
+  // Make sure the gap has a slot in it.
+  void
+  reserve_one ()
+  {
+    if (_gap_begin < _gap_end)
+      return;
+    size_type capacity = _capacity < 8 ? 16 : 2 * _capacity;
+    std::unique_ptr<slot[]> slots (new slot[capacity]);
+    size_type tail = _capacity - _gap_end;
+    for (size_type i = 0; i < _gap_begin; ++i)
+      relocate (i, slots.get (), i);
+    for (size_type i = 0; i < tail; ++i)
+      relocate (_gap_end + i, slots.get (), capacity - tail + i);
+    _slots.swap (slots);
+    _capacity = capacity;
+    _gap_end = capacity - tail;
+  }
+
+  void
+  init ()
+  {
+    _capacity = 0;
+    _gap_begin = 0;
+    _gap_end = 0;
+  }
+
+  void
+  destroy ()
+  {
+    if (!std::is_trivially_destructible<T>::value)
+      for (auto it = begin (); it != end (); ++it)
+	it->~T ();
+  }
+
+public:
+  gap_list ()
+  {
+    init ();
+  }
+
+  // The copy has the gap at the end.
+  gap_list (gap_list const &copy)
+  {
+    init ();
+    size_type n = copy.size ();
+    if (n > 0)
+      {
+	_slots.reset (new slot[n]);
+	_capacity = n;
+	for (auto it = copy.begin (); it != copy.end (); ++it)
+	  new (_slots[_gap_begin++].bytes) T (*it);
+	_gap_end = n;
+      }
+  }
+
+  gap_list (gap_list &&other)
+  {
+    init ();
+    swap (other);
+  }
+
+  template<class InputIterator>
+  gap_list (InputIterator first, InputIterator last)
+  {
+    init ();
+    for (; first != last; ++first)
+      {
+	reserve_one ();
+	new (_slots[_gap_begin++].bytes) T (*first);
+      }
+  }
+
+  ~gap_list ()
+  {
+    destroy ();
+  }
+
+  void
+  swap (gap_list &other)
+  {
+    std::swap (_slots, other._slots);
+    std::swap (_capacity, other._capacity);
+    std::swap (_gap_begin, other._gap_begin);
+    std::swap (_gap_end, other._gap_end);
+  }
+
+  gap_list &
+  operator = (gap_list other)
+  {
+    swap (other);
+    return *this;
+  }
+
+  // The buffer is kept for reuse.
+  void
+  clear ()
+  {
+    destroy ();
+    _gap_begin = 0;
+    _gap_end = _capacity;
+  }
+
+  template <class... Args>
+  void
+  emplace_front (Args &&... args)
+  {
+    if (room_at (0))
+      {
+	reserve_one ();
+	new (_slots[_gap_end - 1].bytes) T (std::forward<Args> (args)...);
+      }
+    else
+      {
+	// ARGS may refer to an element that the gap moves.
+	T tmp (std::forward<Args> (args)...);
+	reserve_one ();
+	move_gap (0);
+	new (_slots[_gap_end - 1].bytes) T (std::move (tmp));
+      }
+    --_gap_end;
+  }
+
+  void
+  push_front (T const &value)
+  {
+    emplace_front (value);
+  }
+
+  void
+  push_front (T &&value)
+  {
+    emplace_front (std::move (value));
+  }
+
+  void
+  pop_front ()
+  {
+    assert (!empty ());
+    move_gap (0);
+    payload (_gap_end++).~T ();
+  }
+
+  reference
+  front ()
+  {
+    return *begin ();
+  }
+
+  const_reference
+  front () const
+  {
+    return *begin ();
+  }
+
+  template <class... Args>
+  iterator
+  emplace_after (const_iterator it, Args &&... args)
+  {
+    size_type i = index_of (it) + 1;
+    if (room_at (i))
+      {
+	reserve_one ();
+	new (_slots[_gap_begin].bytes) T (std::forward<Args> (args)...);
+      }
+    else
+      {
+	// ARGS may refer to an element that the gap moves.
+	T tmp (std::forward<Args> (args)...);
+	reserve_one ();
+	move_gap (i);
+	new (_slots[_gap_begin].bytes) T (std::move (tmp));
+      }
+    ++_gap_begin;
+    return iter (i);
+  }
+
+  iterator
+  insert_after (const_iterator it, T const &value)
+  {
+    return emplace_after (it, value);
+  }
+
+  iterator
+  insert_after (const_iterator it, T &&value)
+  {
+    return emplace_after (it, std::move (value));
+  }
+
+  iterator
+  erase_after (const_iterator it)
+  {
+    size_type i = index_of (it) + 1;
+    move_gap (i);
+    payload (_gap_end++).~T ();
+    return iter (_gap_end);
+  }
+
+  // Erase the elements between FIRST and LAST.  Answer LAST.
+  iterator
+  erase_after (const_iterator first, const_iterator last)
+  {
+    size_type i = index_of (first) + 1;
+    size_type n = (last == cend () ? size () : index_of (last)) - i;
+    move_gap (i);
+    for (size_type k = 0; k < n; ++k)
+      payload (_gap_end++).~T ();
+    return iter (_gap_end);
+  }
+
+  void
+  resize (size_type n, T const &value = T ())
+  {
+    size_type size = this->size ();
+    if (n < size)
+      {
+	move_gap (n);
+	while (_gap_end < _capacity)
+	  payload (_gap_end++).~T ();
+      }
+    else
+      {
+	move_gap (size);
+	for (; size < n; ++size)
+	  {
+	    reserve_one ();
+	    new (_slots[_gap_begin++].bytes) T (value);
+	  }
+      }
+  }
+
+  size_type
+  size () const
+  {
+    return _capacity - (_gap_end - _gap_begin);
+  }
+
+  bool
+  empty () const
+  {
+    return size () == 0;
+  }
+
+  iterator
+  begin ()
+  {
+    return iter (0);
+  }
+
+  const_iterator
+  begin () const
+  {
+    return const_iterator (at (0), at (_gap_begin), at (_gap_end));
+  }
+
+  const_iterator
+  cbegin () const
+  {
+    return begin ();
+  }
+
+  iterator
+  end ()
+  {
+    return iter (_capacity);
+  }
+
+  const_iterator
+  end () const
+  {
+    return const_iterator (at (_capacity), at (_gap_begin), at (_gap_end));
+  }
+
+  const_iterator
+  cend () const
+  {
+    return end ();
+  }
+
+  bool
+  operator == (gap_list const &other) const
+  {
+    const_iterator it = begin ();
+    const_iterator jt = other.begin ();
+    for (; it != end () && jt != other.end (); ++it, ++jt)
+      if (*it != *jt)
+	return false;
+    return (it == end ()) == (jt == other.end ());
+  }
+
+  bool
+  operator != (gap_list const &other) const
+  {
+    return !(*this == other);
+  }
+};
+
+template <class T>
+void
+swap (gap_list<T> &l1, gap_list<T> &l2)
+{
+  l1.swap (l2);
+}
+
+#endif /* _GAP_LIST_H_ */
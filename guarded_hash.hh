@@ -0,0 +1,227 @@
+/*
+ * Implementation of hashtab hardened against hash flooding.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A hashtab whose keys come from untrusted sources.  It hashes with
+ * a randomly seeded fast hash.  When an insertion has to walk more
+ * than ProbeLimit slots, which with a good hash practically doesn't
+ * happen by chance, the table assumes it's being fed colliding keys
+ * and rebuilds itself with SipHash under a fresh random key.  That
+ * happens at most once: keyed hashing is slower, and colliding keys
+ * can't be constructed for it without knowing the key.
+ *
+ * Tables with N <= 100 use linear probing, where long runs are normal
+ * when the table is nearly full, so they should use a higher limit.  */
+
+#ifndef _GUARDED_HASH_H_
+#define _GUARDED_HASH_H_
+
+#include "hash.hh"
+#include "hashers.hh"
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+template <class Key, class T, size_t N,
+	  size_t ProbeLimit = 128,
+	  class Hash2 = typename std::conditional<(N > 100),
+						  default_secondary_hash,
+						  trivial_secondary_hash>::type,
+	  class Equal = std::equal_to<Key>>
+class guarded_hashtab
+{
+  typedef seeded_hash<Key> hasher;
+  typedef hashtab<Key, T, N, hasher, Hash2, Equal> table_type;
+
+  table_type _table;
+
+public:
+  typedef typename table_type::key_type key_type;
+  typedef typename table_type::mapped_type mapped_type;
+  typedef typename table_type::value_type value_type;
+  typedef typename table_type::size_type size_type;
+  typedef typename table_type::reference reference;
+  typedef typename table_type::const_reference const_reference;
+  typedef typename table_type::pointer pointer;
+  typedef typename table_type::const_pointer const_pointer;
+  typedef typename table_type::iterator iterator;
+  typedef typename table_type::const_iterator const_iterator;
+
+  guarded_hashtab (hasher const &hash1 = hasher (),
+		   Hash2 const &hash2 = Hash2 (),
+		   Equal const &equal = Equal ())
+    : _table (hash1, hash2, equal)
+  {}
+
+  template <class InputIterator>
+  guarded_hashtab (InputIterator first, InputIterator last,
+		   hasher const &hash1 = hasher (),
+		   Hash2 const &hash2 = Hash2 (),
+		   Equal const &equal = Equal ())
+    : _table (hash1, hash2, equal)
+  {
+    insert (first, last);
+  }
+
+  void
+  swap (guarded_hashtab &other)
+  {
+    _table.swap (other._table);
+  }
+
+  // Answer whether the table has switched to keyed hashing.
+  bool
+  hardened () const
+  {
+    return _table.hash_function ().keyed ();
+  }
+
+  hasher
+  hash_function () const
+  {
+    return _table.hash_function ();
+  }
+
+  std::pair<iterator, bool>
+  insert (const_reference emt)
+  {
+    size_type probes;
+    std::pair<iterator, bool> ret = _table.insert (emt, probes);
+    if (ret.second && !hardened () && probes > ProbeLimit)
+      {
+	_table.rehash (_table.hash_function ().hardened ());
+	ret.first = _table.find (emt.first);
+      }
+    return ret;
+  }
+
+  iterator
+  insert (const_iterator, const_reference emt)
+  {
+    return insert (emt).first;
+  }
+
+  template <class InputIterator>
+  void
+  insert (InputIterator first, InputIterator last)
+  {
+    for (; first != last; ++first)
+      insert (*first);
+  }
+
+  const_iterator
+  find (key_type const &key) const
+  {
+    return _table.find (key);
+  }
+
+  iterator
+  find (key_type const &key)
+  {
+    return _table.find (key);
+  }
+
+  size_type
+  probe_count (key_type const &key) const
+  {
+    return _table.probe_count (key);
+  }
+
+  size_type
+  size () const
+  {
+    return _table.size ();
+  }
+
+  // This also drops back to the fast hash, with a new seed.
+  void
+  clear ()
+  {
+    _table.clear ();
+  }
+
+  iterator
+  begin ()
+  {
+    return _table.begin ();
+  }
+
+  const_iterator
+  begin () const
+  {
+    return _table.begin ();
+  }
+
+  const_iterator
+  cbegin () const
+  {
+    return _table.cbegin ();
+  }
+
+  iterator
+  end ()
+  {
+    return _table.end ();
+  }
+
+  const_iterator
+  end () const
+  {
+    return _table.end ();
+  }
+
+  const_iterator
+  cend () const
+  {
+    return _table.cend ();
+  }
+
+  bool
+  operator == (guarded_hashtab const &other) const
+  {
+    return _table == other._table;
+  }
+
+  bool
+  operator != (guarded_hashtab const &other) const
+  {
+    return !(*this == other);
+  }
+};
+
+namespace std
+{
+  template <class Key, class T, size_t N, size_t ProbeLimit, class Hash2,
+	    class Equal>
+  struct tuple_size<guarded_hashtab<Key, T, N, ProbeLimit, Hash2, Equal>>
+  {
+    enum { value = N };
+  };
+}
+
+template <class Key, class T, size_t N, size_t ProbeLimit, class Hash2,
+	  class Equal>
+void
+swap (guarded_hashtab<Key, T, N, ProbeLimit, Hash2, Equal> &ht1,
+      guarded_hashtab<Key, T, N, ProbeLimit, Hash2, Equal> &ht2)
+{
+  ht1.swap (ht2);
+}
+
+#endif /* _GUARDED_HASH_H_ */
@@ -18,10 +18,15 @@
  */
 
 #include "hash.hh"
+#include "hashers.hh"
+#include "bloom.hh"
+#include "dense_hash.hh"
+#include "guarded_hash.hh"
 #include "tests.hh"
 
 #include <vector>
 #include <algorithm>
+#include <iterator>
 #include <map>
 #include <cassert>
 #include <iostream>
@@ -120,6 +125,37 @@ membership_tests (T const &test, U &h)
     }
 }
 
+// Only hashtab has for_each_slot, other containers skip this test.
+template <class H>
+void
+visitor_tests (H const &h)
+{}
+
+template <class Key, class T, size_t N, class Hash1, class Hash2, class Equal>
+void
+visitor_tests (hashtab<Key, T, N, Hash1, Hash2, Equal> const &h)
+{
+  std::cout << "v" << std::flush;
+  size_t count = 0;
+  h.for_each_slot ([&h, &count] (std::pair<Key, T> const &v)
+		   {
+		     assert (h.find (v.first) != h.end ());
+		     ++count;
+		   });
+  assert (count == h.size ());
+
+  std::cout << "b" << std::flush;
+  std::vector<Key> keys;
+  for (auto it = h.begin (); it != h.end (); ++it)
+    keys.push_back (it->first);
+  std::vector<typename hashtab<Key, T, N, Hash1, Hash2, Equal>::const_iterator>
+    found;
+  h.find_batch (keys.data (), keys.size (), std::back_inserter (found));
+  assert (found.size () == keys.size ());
+  for (size_t i = 0; i < keys.size (); ++i)
+    assert (found[i] != h.end () && found[i]->first == keys[i]);
+}
+
 template <class H, int M = std::tuple_size<H>::value * 8 / 10>
 void
 tests ()
@@ -188,6 +224,7 @@ tests ()
   {
     H const &h3 = h;
     membership_tests (test, h3);
+    visitor_tests (h3);
   }
 
   std::cout << "4" << std::flush;
@@ -209,9 +246,137 @@ tests ()
     h5.clear ();
     assert (h5.begin () == h5.end ());
     assert (h5.find (test.extra ()) == h5.end ());
+
+    // The table is usable again after clear.
+    h5.insert (vals.begin (), vals.end ());
+    assert (h5 == h);
   }
 }
 
+template <class H, int M = std::tuple_size<H>::value * 8 / 10>
+void
+erase_tests ()
+{
+  TestVector<M, typename H::key_type> const test;
+  std::cout << " e" << std::flush;
+
+  H h;
+  for (auto i = test.begin (); i != test.end (); ++i)
+    h.insert (std::make_pair (*i, *i));
+
+  // Erase and reinsert every other element a couple times, so that
+  // tombstones pile up, get reused and purged.
+  for (size_t round = 0; round < 4; ++round)
+    {
+      std::cout << "." << std::flush;
+      size_t erased = 0, k = 0;
+      for (auto i = test.begin (); i != test.end (); ++i, ++k)
+	if (k % 2 == round % 2)
+	  {
+	    assert (h.erase (*i) == 1);
+	    assert (h.erase (*i) == 0);
+	    ++erased;
+	  }
+      assert (h.size () == test.size () - erased);
+      assert (h.erase (test.extra ()) == 0);
+
+      k = 0;
+      for (auto i = test.begin (); i != test.end (); ++i, ++k)
+	assert ((h.find (*i) == h.end ()) == (k % 2 == round % 2));
+      assert ((size_t)std::distance (h.begin (), h.end ()) == h.size ());
+
+      k = 0;
+      for (auto i = test.begin (); i != test.end (); ++i, ++k)
+	if (k % 2 == round % 2)
+	  assert (h.insert (std::make_pair (*i, *i)).second);
+      assert (h.size () == test.size ());
+    }
+
+  std::cout << "." << std::flush;
+  while (h.begin () != h.end ())
+    h.erase (h.begin ());
+  assert (h.size () == 0);
+  for (auto i = test.begin (); i != test.end (); ++i)
+    assert (h.find (*i) == h.end ());
+
+  for (auto i = test.begin (); i != test.end (); ++i)
+    assert (h.insert (std::make_pair (*i, *i)).second);
+  for (auto i = test.begin (); i != test.end (); ++i)
+    assert (h.find (*i)->second == *i);
+}
+
+// Feed the table keys that all collide under its initial hasher, as
+// if the attacker knew the seed.  The table should notice and switch
+// to keyed hashing.
+template <int N>
+void
+flood_tests ()
+{
+  std::cout << std::endl << " + guarded_hashtab flood N=" << N << " "
+	    << std::flush;
+  enum { Limit = 16, M = N * 8 / 10 < 64 ? N * 8 / 10 : 64 };
+  typedef guarded_hashtab<int, int, N, Limit> H;
+  H h;
+  assert (!h.hardened ());
+
+  auto hash = h.hash_function ();
+  std::vector<int> keys;
+  size_t target = hash (0) % N;
+  for (int k = 0; keys.size () < M; ++k)
+    if (hash (k) % N == target)
+      keys.push_back (k);
+
+  std::cout << "0" << std::flush;
+  for (auto it = keys.begin (); it != keys.end (); ++it)
+    {
+      auto p = h.insert (std::make_pair (*it, *it));
+      assert (p.second);
+      assert (p.first->first == *it);
+    }
+  assert (h.size () == keys.size ());
+  assert (h.hardened () == (M > Limit));
+
+  std::cout << "1" << std::flush;
+  for (auto it = keys.begin (); it != keys.end (); ++it)
+    {
+      auto jt = h.find (*it);
+      assert (jt != h.end ());
+      assert (jt->second == *it);
+      if (h.hardened ())
+	assert (h.probe_count (*it) <= Limit);
+    }
+
+  std::cout << "2" << std::flush;
+  h.clear ();
+  assert (!h.hardened ());
+  assert (h.find (keys.front ()) == h.end ());
+}
+
+// dense_hashtab iterates in insertion order.
+template <class Key, int N>
+void
+dense_order_tests ()
+{
+  std::cout << " o" << std::flush;
+  TestVector<N * 8 / 10, Key> const test;
+  dense_hashtab<Key, Key, N> h;
+  for (auto i = test.rbegin (); i != test.rend (); ++i)
+    h.insert (std::make_pair (*i, *i));
+  assert (std::equal (test.rbegin (), test.rend (), h.begin (),
+		      [] (Key const &k, std::pair<Key, Key> const &v)
+		      {
+			return k == v.first;
+		      }));
+
+  // Reinserting doesn't move anything.
+  if (!test.empty ())
+    {
+      auto p = h.insert (std::make_pair (test.back (), test.back ()));
+      assert (!p.second);
+      assert (p.first == h.begin ());
+    }
+}
+
 template <int N>
 void
 testsuite ()
@@ -220,28 +385,61 @@ testsuite ()
 
   std::cout << std::endl << " + std::map int->int " << std::flush;
   tests<std::map<int, int>, N> ();
+  erase_tests<std::map<int, int>, N> ();
 
   std::cout << std::endl << " + hashtab int->int default hash " << std::flush;
   tests<hashtab<int, int, N>> ();
+  erase_tests<hashtab<int, int, N>> ();
 
   std::cout << std::endl << " + hashtab int->int, hash2 " << std::flush;
   tests<hashtab<int, int, N, hash_int2>> ();
 
   std::cout << std::endl << " + hashtab int->int, hash3, full " << std::flush;
   tests<hashtab<int, int, N, hash_int3>, N - 1> ();
+  erase_tests<hashtab<int, int, N, hash_int3>, N - 1> ();
+
+  std::cout << std::endl << " + hashtab int->int, mix_hash " << std::flush;
+  tests<hashtab<int, int, N, mix_hash<int>>> ();
 
   std::cout << std::endl << " + hashtab int->int, silly hash " << std::flush;
   tests<hashtab<int, int, N, silly_hash<int> >> ();
+  if (N < 10000)
+    // This is quadratic, don't bother with the biggest tables.
+    erase_tests<hashtab<int, int, N, silly_hash<int> >> ();
 
   std::cout << std::endl << " + hashtab string->string default hash " << std::flush;
   tests<hashtab<std::string, std::string, N>> ();
+  erase_tests<hashtab<std::string, std::string, N>> ();
 
   std::cout << std::endl << " + hashtab string->string other hash " << std::flush;
   tests<hashtab<std::string, std::string, N, hash_string>> ();
 
+  std::cout << std::endl << " + hashtab string->string string_hash " << std::flush;
+  tests<hashtab<std::string, std::string, N, string_hash>> ();
+
   std::cout << std::endl << " + hashtab string->string silly hash " << std::flush;
   tests<hashtab<std::string, std::string, N, silly_hash<std::string> > > ();
 
+  std::cout << std::endl << " + guarded_hashtab int->int " << std::flush;
+  tests<guarded_hashtab<int, int, N>> ();
+
+  std::cout << std::endl << " + guarded_hashtab string->string " << std::flush;
+  tests<guarded_hashtab<std::string, std::string, N>> ();
+
+  std::cout << std::endl << " + bloom_hashtab int->int " << std::flush;
+  tests<bloom_hashtab<int, int, N>> ();
+
+  std::cout << std::endl << " + bloom_hashtab string->string " << std::flush;
+  tests<bloom_hashtab<std::string, std::string, N>> ();
+
+  std::cout << std::endl << " + dense_hashtab int->int " << std::flush;
+  tests<dense_hashtab<int, int, N>> ();
+  dense_order_tests<int, N> ();
+
+  std::cout << std::endl << " + dense_hashtab string->string " << std::flush;
+  tests<dense_hashtab<std::string, std::string, N>> ();
+  dense_order_tests<std::string, N> ();
+
   std::cout << std::endl;
 }
 
@@ -281,6 +479,8 @@ main (int argc, char *argv[])
 
   std::cout << std::endl << " + hashtab N=3 " << std::flush;
   tests<hashtab<int, int, 3>, 2> ();
+  erase_tests<hashtab<int, int, 3>, 2> ();
+  erase_tests<hashtab<int, int, 3>, 3> ();
   tests<hashtab<std::string, std::string, 3>, 2> ();
 
   std::cout << std::endl << " + object store tests " << std::flush;
@@ -297,6 +497,10 @@ main (int argc, char *argv[])
     assert (i == 1);
   }
 
+  flood_tests<17> ();
+  flood_tests<1021> ();
+  flood_tests<65521> ();
+
   std::cout << std::endl;
   testsuite<5> ();
   testsuite<17> ();
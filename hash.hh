@@ -23,11 +23,19 @@
  * therefore possible to change the key value through an iterator.
  * (Not const_iterator though.)
  *
- * Removal was not implemented.  */
+ * Removal leaves a tombstone in the slot, so that probe sequences
+ * passing through it stay intact.  Tombstones are reused by later
+ * insertions, and the table is rebuilt when they take up more than
+ * half of the slots not occupied by elements.  */
+
+#ifndef _HASH_H_
+#define _HASH_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <array>
-#include <bitset>
+#include <vector>
 #include <utility>
 #include <functional>
 #include <type_traits>
@@ -85,33 +93,150 @@ struct hashtab
   class iterator;
   class const_iterator;
 
-private:
+protected:
 
   struct slot
   {
     unsigned char bytes[sizeof (value_type)]; // payload
   };
+  // Occupancy bitmap.  This is like std::bitset, but exposes the
+  // underlying words, so that we can skip over empty stretches of the
+  // table 64 slots at a time.
+  struct bitmap
+  {
+    typedef uint64_t word_type;
+    static const size_type word_bits = 64;
+    static const size_type nwords = (N + word_bits - 1) / word_bits;
+    word_type words[nwords];
+
+    bitmap ()
+    {
+      clear ();
+    }
+
+    // Unlike assigning bitmap (), this doesn't build a temporary,
+    // which for big N doesn't fit on the stack.
+    void
+    clear ()
+    {
+      std::fill (words, words + nwords, word_type (0));
+    }
+
+    bool
+    operator [] (size_type i) const
+    {
+      return (words[i / word_bits] >> (i % word_bits)) & 1;
+    }
+
+    void
+    set (size_type i)
+    {
+      words[i / word_bits] |= word_type (1) << (i % word_bits);
+    }
+
+    void
+    reset (size_type i)
+    {
+      words[i / word_bits] &= ~(word_type (1) << (i % word_bits));
+    }
+
+    bool
+    operator == (bitmap const &other) const
+    {
+      return std::equal (words, words + nwords, other.words);
+    }
+
+    // Return position of the first set bit at or after POS, or N if
+    // there is none.  Bits past N are never set, so we don't need to
+    // mask the last word.
+    size_type
+    find_next (size_type pos) const
+    {
+      if (pos >= N)
+	return N;
+      size_type w = pos / word_bits;
+      word_type bits = words[w] & (~word_type (0) << (pos % word_bits));
+      while (bits == 0)
+	if (++w == nwords)
+	  return N;
+	else
+	  bits = words[w];
+      return w * word_bits + __builtin_ctzll (bits);
+    }
+  };
+
+  // std::pair has a user-provided assignment operator, so it's never
+  // trivially copyable.  Copying its bytes is fine as long as both
+  // halves are, though.
+  typedef std::integral_constant<bool,
+				 std::is_trivially_copyable<Key>::value
+				 && std::is_trivially_copyable<T>::value>
+  trivial_copy;
+
   slot _table[N];
-  std::bitset<N> _taken;
+  bitmap _taken;
+  bitmap _dead;
   size_type _size;
+  size_type _dead_count;
 
   primary_hasher _hash1;
   secondary_hasher _hash2;
   key_equal _eq;
 
+  // Find the slot where E is, or else where it should be inserted:
+  // the first tombstone on its probe sequence, or the empty slot that
+  // ends the sequence.  The latter is N if there's no room at all.
   const_iterator
-  find_slot (key_type const &e, bool &found) const
+  find_slot (key_type const &e, bool &found, size_type &probes) const
+  {
+    return find_slot_from (_hash1 (e) % N, e, found, probes);
+  }
+
+  // Like find_slot, but with the home position POS of E already
+  // computed.
+  const_iterator
+  find_slot_from (size_type pos, key_type const &e,
+		  bool &found, size_type &probes) const
   {
-    size_type pos = _hash1 (e) % N;
     size_type d = _hash2 (pos);
+    size_type grave = N;
     found = false;
-    for (; _taken[pos]; pos = (pos + d) % N)
-      if (_eq (tab (pos).first, e))
-	{
-	  found = true;
+    for (probes = 1; ; pos = (pos + d) % N, ++probes)
+      {
+	if (_taken[pos])
+	  {
+	    if (_eq (tab (pos).first, e))
+	      {
+		found = true;
+		return const_iterator (this, pos);
+	      }
+	  }
+	else if (!_dead[pos])
 	  break;
-	}
-    return const_iterator (this, pos);
+	else if (grave == N)
+	  grave = pos;
+
+	if (probes == N)
+	  {
+	    pos = N;
+	    break;
+	  }
+      }
+    return const_iterator (this, grave != N ? grave : pos);
+  }
+
+  const_iterator
+  find_slot (key_type const &e, bool &found) const
+  {
+    size_type probes;
+    return find_slot (e, found, probes);
+  }
+
+  // Like find_slot, but answer just the slot number.
+  size_type
+  find_pos (key_type const &e, bool &found) const
+  {
+    return find_slot (e, found)._pos;
   }
 
   template<class This, class Hashtab>
@@ -143,8 +268,7 @@ private:
     inline void
     find_next ()
     {
-	for (; valid () && !_parent->_taken[_pos]; ++_pos)
-	  ;
+      _pos = _parent->_taken.find_next (_pos);
     }
 
     inline void
@@ -284,18 +408,25 @@ public:
 	   Hash2 const &hash2 = Hash2 (),
 	   Equal const &equal = Equal ())
     : _size (0)
+    , _dead_count (0)
     , _hash1 (hash1)
     , _hash2 (hash2)
     , _eq (equal)
   {}
 
+  // The copy has the same N and the same hashers, so each element
+  // ends up in the same slot as in COPY.  We can therefore clone the
+  // layout instead of rehashing.
   hashtab (hashtab const &copy)
-    : _size (0)
+    : _taken (copy._taken)
+    , _dead (copy._dead)
+    , _size (copy._size)
+    , _dead_count (copy._dead_count)
     , _hash1 (copy._hash1)
     , _hash2 (copy._hash2)
     , _eq (copy._eq)
   {
-    std::copy (copy.begin (), copy.end (), std::inserter (*this, end ()));
+    clone_slots (copy, trivial_copy ());
   }
 
   hashtab (std::initializer_list<value_type> init,
@@ -303,6 +434,7 @@ public:
 	   Hash2 const &hash2 = Hash2 (),
 	   Equal const &equal = Equal ())
     : _size (0)
+    , _dead_count (0)
     , _hash1 (hash1)
     , _hash2 (hash2)
     , _eq (equal)
@@ -316,6 +448,7 @@ public:
 	   Hash2 const &hash2 = Hash2 (),
 	   Equal const &equal = Equal ())
     : _size (0)
+    , _dead_count (0)
     , _hash1 (hash1)
     , _hash2 (hash2)
     , _eq (equal)
@@ -325,16 +458,21 @@ public:
 
   ~hashtab ()
   {
-    std::for_each (begin (), end (), [](value_type &v) { v.~value_type (); });
+    if (!std::is_trivially_destructible<value_type>::value)
+      for_each_slot ([] (value_type &v) { v.~value_type (); });
   }
 
   void
   swap (hashtab &other)
   {
     using std::swap;
-    swap (_table, other._table);
+    if (this == &other)
+      return;
+    swap_slots (other, trivial_copy ());
     swap (_taken, other._taken);
+    swap (_dead, other._dead);
     swap (_size, other._size);
+    swap (_dead_count, other._dead_count);
     swap (_hash1, other._hash1);
     swap (_hash2, other._hash2);
     swap (_eq, other._eq);
@@ -347,7 +485,71 @@ public:
     return *this;
   }
 
-private:
+protected:
+  void
+  clone_slots (hashtab const &copy, std::true_type)
+  {
+    std::memcpy (_table, copy._table, sizeof (_table));
+  }
+
+  void
+  clone_slots (hashtab const &copy, std::false_type)
+  {
+    copy.all_taken ([this, &copy] (size_type i)
+		    {
+		      new (&_table[i]) value_type (copy.tab (i));
+		      return true;
+		    });
+  }
+
+  void
+  swap_slots (hashtab &other, std::true_type)
+  {
+    std::swap (_table, other._table);
+  }
+
+  // Other types can't be swapped as raw bytes, e.g. std::string may
+  // point into its own body.  Swap the slots taken in both tables and
+  // move the rest over to the other side.
+  void
+  swap_slots (hashtab &other, std::false_type)
+  {
+    typedef typename bitmap::word_type word_type;
+    for (size_type w = 0; w < bitmap::nwords; ++w)
+      for (word_type bits = _taken.words[w] | other._taken.words[w];
+	   bits != 0; bits &= bits - 1)
+	{
+	  size_type i = w * bitmap::word_bits + __builtin_ctzll (bits);
+	  if (!_taken[i])
+	    other.relocate_slot (i, *this);
+	  else if (!other._taken[i])
+	    relocate_slot (i, other);
+	  else
+	    {
+	      using std::swap;
+	      swap (tab (i), other.tab (i));
+	    }
+	}
+  }
+
+  // Put V to its slot.  Its key must not be in the table yet.
+  void
+  place (value_type &&v)
+  {
+    bool found;
+    size_type pos = find_slot (v.first, found)._pos;
+    new (&_table[pos]) value_type (std::move (v));
+    _taken.set (pos);
+    ++_size;
+  }
+
+  void
+  relocate_slot (size_type i, hashtab &to)
+  {
+    new (&to._table[i]) value_type (std::move (tab (i)));
+    tab (i).~value_type ();
+  }
+
   value_type const &
   tab (size_type i) const
   {
@@ -364,31 +566,73 @@ private:
     return object;
   }
 
+  // Call PRED with position of each taken slot, in order, until it
+  // returns false.  Answer whether all calls returned true.
+  template <class Pred>
+  bool
+  all_taken (Pred pred) const
+  {
+    typedef typename bitmap::word_type word_type;
+    for (size_type w = 0; w < bitmap::nwords; ++w)
+      for (word_type bits = _taken.words[w]; bits != 0; bits &= bits - 1)
+	if (!pred (w * bitmap::word_bits + __builtin_ctzll (bits)))
+	  return false;
+    return true;
+  }
+
   // We have to ignore what's in the unused (and uninitialized)
   // portions of the table.
   bool
   equal_slots (hashtab const &other) const
   {
     // N.B. at this point we already know that _taken == other._taken
-    for (size_type i = 0; i < N; ++i)
-      if (_taken[i] && tab (i) != other.tab (i))
-	return false;
-    return true;
+    return all_taken ([this, &other] (size_type i)
+		      {
+			return !(tab (i) != other.tab (i));
+		      });
   }
 
   bool
   contains_all (hashtab const &other, bool just_keys) const
   {
-    for (const_iterator it = other.begin (); it != other.end (); ++it)
-      {
-	const_iterator jt = find (it->first);
-	if (jt == end () || (!just_keys && jt->second != it->second))
-	  return false;
-      }
-    return true;
+    return other.all_taken ([this, &other, just_keys] (size_type i)
+			    {
+			      value_type const &v = other.tab (i);
+			      const_iterator jt = find (v.first);
+			      return !(jt == end ()
+				       || (!just_keys
+					   && jt->second != v.second));
+			    });
   }
 
 public:
+  // Call FN on each element of the table.  Unlike iteration through
+  // begin/end, this walks the occupancy bitmap a word at a time and
+  // has no per-element iterator state, so the inner loop is tight
+  // enough for the compiler to unroll.  Returns FN, as std::for_each
+  // does.
+  template <class Fn>
+  Fn
+  for_each_slot (Fn fn)
+  {
+    typedef typename bitmap::word_type word_type;
+    for (size_type w = 0; w < bitmap::nwords; ++w)
+      for (word_type bits = _taken.words[w]; bits != 0; bits &= bits - 1)
+	fn (tab (w * bitmap::word_bits + __builtin_ctzll (bits)));
+    return fn;
+  }
+
+  template <class Fn>
+  Fn
+  for_each_slot (Fn fn) const
+  {
+    typedef typename bitmap::word_type word_type;
+    for (size_type w = 0; w < bitmap::nwords; ++w)
+      for (word_type bits = _taken.words[w]; bits != 0; bits &= bits - 1)
+	fn (tab (w * bitmap::word_bits + __builtin_ctzll (bits)));
+    return fn;
+  }
+
   bool
   operator == (hashtab const &other) const
   {
@@ -431,18 +675,35 @@ public:
   std::pair<iterator, bool>
   insert (const_reference emt)
   {
+    size_type probes;
+    return insert (emt, probes);
+  }
+
+  // Like insert, but also answer in PROBES how many slots the
+  // insertion examined, or 0 if the table was full.
+  std::pair<iterator, bool>
+  insert (const_reference emt, size_type &probes)
+  {
+    probes = 0;
     if (_size == N)
       // Or should we raise exception?
       return std::make_pair (end (), false);
 
     bool found;
-    const_iterator it = find_slot (emt.first, found);
+    const_iterator it = find_slot (emt.first, found, probes);
     // N.B. """Inserts t if and only if there is no element in the
     // container with key equivalent to the key of t."""
     if (found)
       return std::make_pair (iterator (this, it._pos), false);
+    if (it._pos == N)
+      return std::make_pair (end (), false);
 
-    _taken[it._pos] = true;
+    if (_dead[it._pos])
+      {
+	_dead.reset (it._pos);
+	--_dead_count;
+      }
+    _taken.set (it._pos);
     new (&_table[it._pos]) value_type (emt);
     ++_size;
 
@@ -463,6 +724,94 @@ public:
       insert (*first);
   }
 
+  // This invalidates iterators if the table gets rebuilt.
+  void
+  erase (const_iterator it)
+  {
+    remove_slot (it._pos);
+    if (_size == 0)
+      {
+	_dead.clear ();
+	_dead_count = 0;
+      }
+    else if (too_many_tombstones ())
+      rebuild ();
+  }
+
+  size_type
+  erase (key_type const &e)
+  {
+    const_iterator it = find (e);
+    if (it == end ())
+      return 0;
+    erase (it);
+    return 1;
+  }
+
+protected:
+  void
+  remove_slot (size_type pos)
+  {
+    tab (pos).~value_type ();
+    _taken.reset (pos);
+    _dead.set (pos);
+    ++_dead_count;
+    --_size;
+  }
+
+  bool
+  too_many_tombstones () const
+  {
+    return 2 * _dead_count > N - _size;
+  }
+
+  // Drop the tombstones by reinserting every element in place, with
+  // no extra storage.  While this runs, _dead marks the slots whose
+  // elements have yet to be placed, and those count as free.  An
+  // element that lands on such a slot swaps with its occupant, which
+  // is then placed in turn.  Whatever state a derived class keeps
+  // per slot has to travel along: EXCHANGE (pos) is called whenever
+  // the carried element is swapped with slot POS, including when it's
+  // picked up from and put down to a slot.
+  template <class Fn>
+  void
+  rebuild (Fn exchange)
+  {
+    _dead = _taken;
+    _taken.clear ();
+    _dead_count = 0;
+    for (size_type i = _dead.find_next (0); i < N; i = _dead.find_next (i))
+      {
+	_dead.reset (i);
+	value_type carried (std::move (tab (i)));
+	tab (i).~value_type ();
+	exchange (i);
+	for (;;)
+	  {
+	    size_type pos = _hash1 (carried.first) % N;
+	    size_type d = _hash2 (pos);
+	    while (_taken[pos])
+	      pos = (pos + d) % N;
+	    _taken.set (pos);
+	    exchange (pos);
+	    if (!_dead[pos])
+	      {
+		new (&_table[pos]) value_type (std::move (carried));
+		break;
+	      }
+	    _dead.reset (pos);
+	    std::swap (carried, tab (pos));
+	  }
+      }
+  }
+
+  void
+  rebuild ()
+  {
+    rebuild ([] (size_type) {});
+  }
+
+public:
   const_iterator
   find (key_type const &e) const
   {
@@ -481,16 +830,104 @@ public:
     return iterator (this, it._pos);
   }
 
+  // Look up COUNT keys starting at KEYS, and write an iterator for
+  // each of them to OUT (end() for keys that are not in the table).
+  // Keys are hashed in groups, and the home slots of the whole group
+  // are prefetched before the first of them is probed, so that the
+  // cache misses of a group overlap instead of coming one by one.
+  template <class OutputIterator>
+  OutputIterator
+  find_batch (key_type const *keys, size_type count,
+	      OutputIterator out) const
+  {
+    enum { group = 16 };
+    size_type pos[group];
+    for (size_type base = 0; base < count; base += group)
+      {
+	size_type n = std::min (size_type (group), count - base);
+	for (size_type i = 0; i < n; ++i)
+	  {
+	    pos[i] = _hash1 (keys[base + i]) % N;
+	    __builtin_prefetch (&_taken.words[pos[i] / bitmap::word_bits]);
+	    __builtin_prefetch (&_table[pos[i]]);
+	  }
+	for (size_type i = 0; i < n; ++i)
+	  {
+	    bool found;
+	    size_type probes;
+	    const_iterator it = find_slot_from (pos[i], keys[base + i],
+						found, probes);
+	    *out++ = found ? it : end ();
+	  }
+      }
+    return out;
+  }
+
+  // Rebuild the table, with HASH1 as the new primary hasher.
+  void
+  rehash (Hash1 const &hash1)
+  {
+    std::vector<value_type> saved;
+    saved.reserve (_size);
+    for_each_slot ([&saved] (value_type &v)
+		   {
+		     saved.push_back (std::move (v));
+		     v.~value_type ();
+		   });
+
+    _taken.clear ();
+    _dead.clear ();
+    _size = 0;
+    _dead_count = 0;
+    _hash1 = hash1;
+    for (auto it = saved.begin (); it != saved.end (); ++it)
+      place (std::move (*it));
+  }
+
+  primary_hasher
+  hash_function () const
+  {
+    return _hash1;
+  }
+
+  // Answer how many slots a lookup of E examines.  This is meant
+  // for judging how well a hash function suits the keys.
+  size_type
+  probe_count (key_type const &e) const
+  {
+    bool found;
+    size_type probes;
+    find_slot (e, found, probes);
+    return probes;
+  }
+
   size_type
   size () const
   {
     return _size;
   }
 
+  // Empty the table in place, keeping the hashers.
+  void
+  reset ()
+  {
+    if (!std::is_trivially_destructible<value_type>::value)
+      for_each_slot ([] (value_type &v) { v.~value_type (); });
+    _taken.clear ();
+    _dead.clear ();
+    _size = 0;
+    _dead_count = 0;
+  }
+
+  // Empty the table and start over with default hashers.  This is
+  // done in place, as the table may be too big for a temporary.
   void
   clear ()
   {
-    *this = hashtab ();
+    reset ();
+    _hash1 = Hash1 ();
+    _hash2 = Hash2 ();
+    _eq = Equal ();
   }
 
   iterator
@@ -546,3 +983,5 @@ swap (hashtab<Key, T, N, Hash1, Hash2> &ht1,
 {
   ht1.swap (ht2);
 }
+
+#endif /* _HASH_H_ */
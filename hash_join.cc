@@ -0,0 +1,158 @@
+/*
+ * Test suite for hash join and group-by.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hash_join.hh"
+#include "tests.hh"
+
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+template <class Key>
+struct record
+{
+  Key key;
+  int id;
+};
+
+template <class Key>
+Key
+key_of (record<Key> const &r)
+{
+  return r.key;
+}
+
+// Build side has each key of TEST DUP times, the probe side has each
+// key of TEST and TEST2 once.  Answer the expected pairs of ids.
+template <class Key, int M>
+std::multimap<int, int>
+make_sides (std::vector<record<Key>> &build,
+	    std::vector<record<Key>> &probe, int dup)
+{
+  TestVector<M, Key> const test;
+  TestVector<M * 2, Key> const test2;
+  std::multimap<Key, int> by_key;
+  for (int d = 0; d < dup; ++d)
+    for (auto i = test.begin (); i != test.end (); ++i)
+      {
+	record<Key> r = { *i, int (build.size ()) };
+	build.push_back (r);
+	by_key.insert (std::make_pair (*i, r.id));
+      }
+
+  std::multimap<int, int> expect;
+  for (auto i = test2.begin (); i != test2.end (); ++i)
+    {
+      record<Key> r = { *i, int (probe.size ()) };
+      probe.push_back (r);
+      auto range = by_key.equal_range (*i);
+      for (auto it = range.first; it != range.second; ++it)
+	expect.insert (std::make_pair (it->second, r.id));
+    }
+  return expect;
+}
+
+template <class Key, int N, int M>
+void
+tests ()
+{
+  typedef record<Key> R;
+  std::cout << std::endl << " + " << typeid (Key).name ()
+	    << " N=" << N << " M=" << M << " " << std::flush;
+
+  for (int dup = 1; dup <= 3; ++dup)
+    {
+      std::vector<R> build, probe;
+      std::multimap<int, int> expect = make_sides<Key, M> (build, probe, dup);
+
+      std::cout << dup << std::flush;
+      std::multimap<int, int> got;
+      // Matches for one probe record come in build order.
+      int last_probe = -1, last_build = -1;
+      auto collect = [&] (R const &b, R const &p)
+	{
+	  assert (b.key == p.key);
+	  if (p.id == last_probe)
+	    assert (b.id > last_build);
+	  last_probe = p.id;
+	  last_build = b.id;
+	  got.insert (std::make_pair (b.id, p.id));
+	};
+
+      // The table holds distinct keys, duplicates are chained.
+      size_t n = hash_join<N> (build, probe, key_of<Key>, key_of<Key>,
+			       collect);
+      assert (n == expect.size ());
+      assert (got == expect);
+      got.clear ();
+
+      // Partitions are sized for N / 2 build records.
+      n = partitioned_hash_join<N / 4> (build, probe,
+					key_of<Key>, key_of<Key>, collect);
+      assert (n == expect.size ());
+      assert (got == expect);
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::cout << "running hash_join tests" << std::flush;
+  tests<int, 17, 10> ();
+  tests<int, 1021, 800> ();
+  tests<int, 65521, 50000> ();
+  tests<std::string, 1021, 800> ();
+  tests<std::string, 8191, 6000> ();
+
+  std::cout << std::endl << " + overflow " << std::flush;
+  {
+    std::vector<record<int>> build, probe;
+    make_sides<int, 100> (build, probe, 1);
+    bool thrown = false;
+    try
+      {
+	hash_join<17> (build, probe, key_of<int>, key_of<int>,
+		       [] (record<int> const &, record<int> const &) {});
+      }
+    catch (std::length_error const &)
+      {
+	thrown = true;
+      }
+    assert (thrown);
+  }
+
+  std::cout << std::endl << " + group " << std::flush;
+  {
+    std::vector<record<int>> build, probe;
+    make_sides<int, 800> (build, probe, 3);
+    hashtab<int, int, 1021> sums;
+    hash_group (sums, build, key_of<int>, 0,
+		[] (int &acc, record<int> const &r) { acc += r.id; });
+    assert (sums.size () == 800);
+    std::map<int, int> expect;
+    for (auto it = build.begin (); it != build.end (); ++it)
+      expect[it->key] += it->id;
+    for (auto it = expect.begin (); it != expect.end (); ++it)
+      assert (sums.find (it->first)->second == it->second);
+  }
+  std::cout << std::endl;
+}
@@ -0,0 +1,275 @@
+/*
+ * Hash join and group-by on top of hashtab.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* hash_join builds a table from the build side: a hashtab with N
+ * slots that maps each key to the first build record with that key.
+ * Further records with the same key are chained through an array of
+ * indices.  The probe side is then looked up with
+ * hashtab::find_batch, a group of records at a time, and each match
+ * is passed to a callback as (build record, probe record).
+ *
+ * The build side has to fit into the table.  Pick N so that the
+ * table fits in L2 and use partitioned_hash_join for build sides
+ * that are larger.  It splits both sides by a few bits of the key
+ * hash, and joins the matching partitions one pair at a time with
+ * the same small table.  That costs a pass over both inputs, but
+ * every probe then hits the cache.
+ *
+ * Both sides are random-access containers of records, and a key
+ * function extracts the join key from a record.  Keys should be
+ * distributed well by Hash: the partitions are chosen by the top
+ * bits of mix64 of the hash, and the table slot by the hash modulo
+ * N.  */
+
+#ifndef _HASH_JOIN_H_
+#define _HASH_JOIN_H_
+
+#include "hash.hh"
+#include "hashers.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace hash_join_detail
+{
+  // No next record with the same key.
+  static const uint32_t none = uint32_t (-1);
+
+  template <class Key, size_t N, class Hash>
+  class join_table
+  {
+    typedef hashtab<Key, uint32_t, N, Hash> table_type;
+    typedef typename table_type::const_iterator const_iterator;
+
+    // Heap-allocated, as N is usually large.
+    std::unique_ptr<table_type> _table;
+    std::vector<uint32_t> _next;
+
+  public:
+    // NBUILD is the size of the whole build side.
+    explicit join_table (size_t nbuild)
+      : _table (new table_type ())
+      , _next (nbuild, none)
+    {}
+
+    // Insert the build records at the positions IDX (COUNT of them),
+    // keyed by KEYS.  Each build record can only be inserted once.
+    void
+    build (Key const *keys, uint32_t const *idx, size_t count)
+    {
+      _table->reset ();
+      // Go backwards, so that the chains come out in build order.
+      for (size_t i = count; i-- > 0; )
+	{
+	  auto p = _table->insert (std::make_pair (keys[i], idx[i]));
+	  if (p.first == _table->end ())
+	    throw std::length_error ("hash_join: build side doesn't fit");
+	  if (!p.second)
+	    {
+	      _next[idx[i]] = p.first->second;
+	      p.first->second = idx[i];
+	    }
+	}
+    }
+
+    // Probe with COUNT keys, which belong to probe records at the
+    // positions IDX.  Answer the number of matches.
+    template <class Build, class Probe, class Fn>
+    size_t
+    probe (Key const *keys, uint32_t const *idx, size_t count,
+	   Build const &build, Probe const &probe, Fn &fn) const
+    {
+      enum { group = 64 };
+      const_iterator found[group];
+      size_t matches = 0;
+      for (size_t base = 0; base < count; base += group)
+	{
+	  size_t n = std::min (size_t (group), count - base);
+	  _table->find_batch (keys + base, n, found);
+	  for (size_t i = 0; i < n; ++i)
+	    if (found[i] != _table->end ())
+	      for (uint32_t b = found[i]->second; b != none; b = _next[b])
+		{
+		  fn (build[b], probe[idx[base + i]]);
+		  ++matches;
+		}
+	}
+      return matches;
+    }
+  };
+
+  template <class Range, class KeyFn>
+  struct key_of
+  {
+    typedef typename std::decay
+      <decltype (std::declval<KeyFn> ()
+		 (std::declval<Range const &> ()[0]))>::type type;
+  };
+}
+
+// Join BUILD with PROBE on the keys that BKEY and PKEY extract from
+// their records, and call FN (build_record, probe_record) for each
+// match.  Answer the number of matches.  Throws std::length_error if
+// the build side has more distinct keys than the table can hold.
+template <size_t N, class Build, class Probe, class BuildKey,
+	  class ProbeKey, class Fn,
+	  class Key = typename hash_join_detail::key_of<Build, BuildKey>::type,
+	  class Hash = std::hash<Key>>
+size_t
+hash_join (Build const &build, Probe const &probe,
+	   BuildKey bkey, ProbeKey pkey, Fn fn)
+{
+  hash_join_detail::join_table<Key, N, Hash> table (build.size ());
+
+  std::vector<Key> keys;
+  std::vector<uint32_t> idx;
+  keys.reserve (build.size ());
+  idx.reserve (build.size ());
+  for (size_t i = 0; i < build.size (); ++i)
+    {
+      keys.push_back (bkey (build[i]));
+      idx.push_back (uint32_t (i));
+    }
+  table.build (keys.data (), idx.data (), keys.size ());
+
+  // Probe in chunks, so that the key buffer stays small.
+  enum { chunk = 4096 };
+  size_t matches = 0;
+  for (size_t base = 0; base < probe.size (); base += chunk)
+    {
+      size_t n = std::min (size_t (chunk), probe.size () - base);
+      keys.clear ();
+      idx.clear ();
+      for (size_t i = base; i < base + n; ++i)
+	{
+	  keys.push_back (pkey (probe[i]));
+	  idx.push_back (uint32_t (i));
+	}
+      matches += table.probe (keys.data (), idx.data (), n,
+			      build, probe, fn);
+    }
+  return matches;
+}
+
+// Like hash_join, but the build side doesn't have to fit into N
+// slots.  Both sides are split into as many partitions (a power of
+// two) as it takes for each to fill at most half of the table.  Even
+// so, if the keys are heavily skewed, one partition might not fit,
+// and std::length_error is thrown.
+template <size_t N, class Build, class Probe, class BuildKey,
+	  class ProbeKey, class Fn,
+	  class Key = typename hash_join_detail::key_of<Build, BuildKey>::type,
+	  class Hash = std::hash<Key>>
+size_t
+partitioned_hash_join (Build const &build, Probe const &probe,
+		       BuildKey bkey, ProbeKey pkey, Fn fn)
+{
+  static_assert (N >= 2, "partitions need at least two slots");
+  unsigned bits = 0;
+  while ((size_t (N / 2) << bits) < build.size ())
+    ++bits;
+  size_t const nparts = size_t (1) << bits;
+  Hash hash;
+  auto part_of = [&hash, bits] (Key const &k) -> size_t
+    {
+      return bits == 0 ? 0 : mix64 (hash (k)) >> (64 - bits);
+    };
+
+  // Lay out keys and record positions of each side partition by
+  // partition.  START gets the first position of each partition.
+  auto scatter = [&] (std::vector<Key> const &all,
+		      std::vector<Key> &keys, std::vector<uint32_t> &idx,
+		      std::vector<size_t> &start)
+    {
+      std::vector<size_t> part (all.size ());
+      start.assign (nparts + 1, 0);
+      for (size_t i = 0; i < all.size (); ++i)
+	{
+	  part[i] = part_of (all[i]);
+	  ++start[part[i] + 1];
+	}
+      for (size_t p = 0; p < nparts; ++p)
+	start[p + 1] += start[p];
+
+      std::vector<size_t> fill (start.begin (), start.end () - 1);
+      keys.resize (all.size ());
+      idx.resize (all.size ());
+      for (size_t i = 0; i < all.size (); ++i)
+	{
+	  size_t at = fill[part[i]]++;
+	  keys[at] = all[i];
+	  idx[at] = uint32_t (i);
+	}
+    };
+
+  std::vector<Key> all, bkeys, pkeys;
+  std::vector<uint32_t> bidx, pidx;
+  std::vector<size_t> bstart, pstart;
+
+  all.reserve (build.size ());
+  for (size_t i = 0; i < build.size (); ++i)
+    all.push_back (bkey (build[i]));
+  scatter (all, bkeys, bidx, bstart);
+
+  all.clear ();
+  all.reserve (probe.size ());
+  for (size_t i = 0; i < probe.size (); ++i)
+    all.push_back (pkey (probe[i]));
+  scatter (all, pkeys, pidx, pstart);
+
+  hash_join_detail::join_table<Key, N, Hash> table (build.size ());
+  size_t matches = 0;
+  for (size_t p = 0; p < nparts; ++p)
+    {
+      if (pstart[p] == pstart[p + 1])
+	continue;
+      table.build (bkeys.data () + bstart[p], bidx.data () + bstart[p],
+		   bstart[p + 1] - bstart[p]);
+      matches += table.probe (pkeys.data () + pstart[p],
+			      pidx.data () + pstart[p],
+			      pstart[p + 1] - pstart[p], build, probe, fn);
+    }
+  return matches;
+}
+
+// Fold the records of RECORDS into TABLE, grouped by the key that
+// KEY extracts.  Each group starts as INIT, and AGG (acc, record) is
+// called for each record of the group.  Throws std::length_error if
+// there are more groups than the table can hold.
+template <class Table, class Records, class KeyFn, class Agg>
+void
+hash_group (Table &table, Records const &records, KeyFn key,
+	    typename Table::mapped_type const &init, Agg agg)
+{
+  for (size_t i = 0; i < records.size (); ++i)
+    {
+      auto p = table.insert (std::make_pair (key (records[i]), init));
+      if (p.first == table.end ())
+	throw std::length_error ("hash_group: too many groups");
+      agg (p.first->second, records[i]);
+    }
+}
+
+#endif /* _HASH_JOIN_H_ */
@@ -0,0 +1,270 @@
+/*
+ * Hash functions for use with hashtab and friends.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* std::hash of an integer is the identity in libstdc++.  That's fast,
+ * but regular keys then produce regular probe sequences: e.g. with
+ * keys in arithmetic progression, a hashtab lookup miss can walk
+ * hundreds of slots.  The hashers here spread all input bits over
+ * the whole result, and are cheap enough to use by default.  */
+
+#ifndef _HASHERS_H_
+#define _HASHERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <random>
+#include <type_traits>
+#ifdef __SSE4_2__
+# include <nmmintrin.h>
+#endif
+
+// The MurmurHash3 64-bit finalizer.  It's a bijection, and each input
+// bit affects each output bit with probability close to 1/2.
+inline uint64_t
+mix64 (uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// Hash for integral keys (and anything else that converts to
+// uint64_t without loss).
+template <class Key>
+struct mix_hash
+{
+  typedef size_t result_type;
+  typedef Key argument_type;
+  size_t
+  operator () (Key k) const
+  {
+    return mix64 (uint64_t (k));
+  }
+};
+
+namespace hashers_detail
+{
+  inline uint64_t
+  rotl (uint64_t v, unsigned n)
+  {
+    return (v << n) | (v >> (64 - n));
+  }
+
+  // Load up to eight bytes.  memcpy compiles to a plain (possibly
+  // unaligned) load.
+  inline uint64_t
+  load (char const *p, size_t len)
+  {
+    uint64_t w = 0;
+    std::memcpy (&w, p, len);
+    return w;
+  }
+
+  const uint64_t k1 = 0x87c37b91114253d5ULL;
+  const uint64_t k2 = 0x4cf5ad432745937fULL;
+
+#ifdef __SSE4_2__
+  // Two independent CRC32C lanes, which the CPU computes at one word
+  // per cycle.  CRC is linear, so the result needs the final mix to
+  // be usable as a hash.
+  inline uint64_t
+  hash_bytes (char const *p, size_t len, uint64_t seed)
+  {
+    uint64_t a = uint32_t (seed), b = uint32_t (seed >> 32) ^ len;
+    for (; len >= 16; p += 16, len -= 16)
+      {
+	a = _mm_crc32_u64 (a, load (p, 8));
+	b = _mm_crc32_u64 (b, load (p + 8, 8));
+      }
+    if (len >= 8)
+      {
+	a = _mm_crc32_u64 (a, load (p, 8));
+	p += 8;
+	len -= 8;
+      }
+    b = _mm_crc32_u64 (b, load (p, len));
+    return mix64 ((b << 32) | a);
+  }
+#else
+  // Murmur-style word-at-a-time hashing.
+  inline uint64_t
+  hash_bytes (char const *p, size_t len, uint64_t seed)
+  {
+    uint64_t h = seed ^ (len * k2);
+    for (; len >= 8; p += 8, len -= 8)
+      h = rotl (h ^ (rotl (load (p, 8) * k1, 31) * k2), 27) * 5 + 0x52dce729;
+    h ^= rotl (load (p, len) * k1, 31) * k2;
+    return mix64 (h);
+  }
+#endif
+
+  // SipHash-1-3.  That's a keyed hash: without knowing the key, an
+  // attacker can't construct colliding inputs.  It's about three
+  // times slower than hash_bytes.
+  inline uint64_t
+  siphash (char const *p, size_t len, uint64_t k0, uint64_t k1)
+  {
+    uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+    uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+    uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+    uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+
+    auto round = [&] ()
+      {
+	v0 += v1; v1 = rotl (v1, 13); v1 ^= v0; v0 = rotl (v0, 32);
+	v2 += v3; v3 = rotl (v3, 16); v3 ^= v2;
+	v0 += v3; v3 = rotl (v3, 21); v3 ^= v0;
+	v2 += v1; v1 = rotl (v1, 17); v1 ^= v2; v2 = rotl (v2, 32);
+      };
+
+    uint64_t last = uint64_t (len) << 56;
+    for (; len >= 8; p += 8, len -= 8)
+      {
+	uint64_t m = load (p, 8);
+	v3 ^= m;
+	round ();
+	v0 ^= m;
+      }
+    last |= load (p, len);
+    v3 ^= last;
+    round ();
+    v0 ^= last;
+
+    v2 ^= 0xff;
+    round ();
+    round ();
+    round ();
+    return v0 ^ v1 ^ v2 ^ v3;
+  }
+
+  template <class Key>
+  typename std::enable_if<std::is_integral<Key>::value, uint64_t>::type
+  seeded (Key k, uint64_t seed)
+  {
+    return mix64 (uint64_t (k) ^ seed);
+  }
+
+  inline uint64_t
+  seeded (std::string const &str, uint64_t seed)
+  {
+    return hash_bytes (str.data (), str.size (), seed);
+  }
+
+  template <class Key>
+  typename std::enable_if<std::is_integral<Key>::value, uint64_t>::type
+  keyed (Key k, uint64_t k0, uint64_t k1)
+  {
+    return siphash (reinterpret_cast<char const *> (&k), sizeof (k), k0, k1);
+  }
+
+  inline uint64_t
+  keyed (std::string const &str, uint64_t k0, uint64_t k1)
+  {
+    return siphash (str.data (), str.size (), k0, k1);
+  }
+
+  inline uint64_t
+  random_seed ()
+  {
+    std::random_device rd;
+    return (uint64_t (rd ()) << 32) ^ rd ();
+  }
+}
+
+// Hash for std::string, eight bytes at a time.  When compiled with
+// SSE 4.2 support, this uses the hardware CRC32C instruction.
+struct string_hash
+{
+  typedef size_t result_type;
+  typedef std::string const &argument_type;
+
+  size_t
+  operator () (std::string const &str) const
+  {
+    return hashers_detail::hash_bytes (str.data (), str.size (), 0);
+  }
+
+  size_t
+  operator () (char const *data, size_t len) const
+  {
+    return hashers_detail::hash_bytes (data, len, 0);
+  }
+};
+
+// Hash for integral and string keys, seeded randomly for each
+// instance, so that colliding keys can't be prepared in advance.
+// The fast hash is still not cryptographically strong.  A seeded_hash
+// can therefore be switched to SipHash with a fresh key, when keys
+// that collide anyway are detected (see guarded_hashtab).
+template <class Key>
+class seeded_hash
+{
+  uint64_t _k0;
+  uint64_t _k1;
+  bool _keyed;
+
+public:
+  typedef size_t result_type;
+  typedef Key const &argument_type;
+
+  seeded_hash ()
+    : _k0 (hashers_detail::random_seed ())
+    , _k1 (hashers_detail::random_seed ())
+    , _keyed (false)
+  {}
+
+  // For reproducible tests.
+  explicit seeded_hash (uint64_t k0, uint64_t k1 = 0, bool keyed = false)
+    : _k0 (k0)
+    , _k1 (k1)
+    , _keyed (keyed)
+  {}
+
+  // Answer whether this hashes with SipHash.
+  bool
+  keyed () const
+  {
+    return _keyed;
+  }
+
+  // Return a hasher that uses SipHash with a fresh random key.
+  seeded_hash
+  hardened () const
+  {
+    seeded_hash ret;
+    ret._keyed = true;
+    return ret;
+  }
+
+  size_t
+  operator () (Key const &k) const
+  {
+    if (_keyed)
+      return hashers_detail::keyed (k, _k0, _k1);
+    else
+      return hashers_detail::seeded (k, _k0);
+  }
+};
+
+#endif /* _HASHERS_H_ */
@@ -0,0 +1,121 @@
+/*
+ * Test suite for allocation of memory backed by huge pages.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "huge_pages.hh"
+#include "hash.hh"
+#include "slist.hh"
+#include "forward_vec.hh"
+#include "tests.hh"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct D
+{
+  int *i;
+  D (int *ii) : i (ii) {}
+  ~D () { ++*i; }
+};
+
+int
+main (int argc, char *argv[])
+{
+  std::cout << "running huge page tests" << std::flush;
+
+  std::cout << std::endl << " + huge_alloc " << std::flush;
+  {
+    size_t sizes[] = { 1, 4096, huge_page_size - 1, huge_page_size,
+		       huge_page_size + 1, 5 * huge_page_size };
+    for (size_t i = 0; i < sizeof (sizes) / sizeof (*sizes); ++i)
+      {
+	char *p = static_cast<char *> (huge_alloc (sizes[i]));
+	if (sizes[i] >= huge_page_size)
+	  assert (uintptr_t (p) % huge_page_size == 0);
+	else
+	  assert (uintptr_t (p) % huge_small_align == 0);
+	p[0] = 1;
+	p[sizes[i] - 1] = 2;
+	huge_free (p, sizes[i]);
+	std::cout << "." << std::flush;
+      }
+  }
+
+  std::cout << std::endl << " + std::vector with huge_page_allocator "
+	    << std::flush;
+  {
+    std::vector<int, huge_page_allocator<int>> v;
+    for (int i = 0; i < 1000000; ++i)
+      v.push_back (i);
+    for (int i = 0; i < 1000000; ++i)
+      assert (v[i] == i);
+  }
+
+  std::cout << std::endl << " + forward_vec with huge_page_allocator "
+	    << std::flush;
+  {
+    TestVector<1000, int> const test;
+    forward_vec<int, huge_page_allocator<int>> fv (test.begin (), test.end ());
+    auto jt = test.begin ();
+    for (auto it = fv.begin (); it != fv.end (); ++it, ++jt)
+      assert (*it == *jt);
+  }
+
+  std::cout << std::endl << " + make_huge hashtab " << std::flush;
+  {
+    enum { N = 65521, M = N * 8 / 10 };
+    typedef hashtab<int, int, N> H;
+    TestVector<M, int> const test;
+    huge_ptr<H> h = make_huge<H> ();
+    for (auto it = test.begin (); it != test.end (); ++it)
+      assert (h->insert (std::make_pair (*it, *it)).second);
+    for (auto it = test.begin (); it != test.end (); ++it)
+      assert (h->find (*it)->second == *it);
+    assert (h->size () == M);
+  }
+
+  std::cout << std::endl << " + make_huge slist " << std::flush;
+  {
+    enum { N = 16384 };
+    typedef slist<std::string, N> H;
+    TestVector<N, std::string> const test;
+    huge_ptr<H> h = make_huge<H> (test.begin (), test.end ());
+    assert (std::equal (h->begin (), h->end (), test.begin ()));
+  }
+
+  std::cout << std::endl << " + make_huge aligns " << std::flush;
+  {
+    typedef slist<int, 100, slist_block_layout> H;
+    huge_ptr<H> h = make_huge<H> ();
+    assert (uintptr_t (h.get ()) % alignof (H) == 0);
+  }
+
+  std::cout << std::endl << " + make_huge destroys " << std::flush;
+  {
+    int ct = 0;
+    {
+      huge_ptr<D> d = make_huge<D> (&ct);
+    }
+    assert (ct == 1);
+  }
+
+  std::cout << std::endl;
+}
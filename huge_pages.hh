@@ -0,0 +1,182 @@
+/*
+ * Allocation of memory backed by huge pages.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Random probes into a big table miss the TLB almost every time when
+ * it's mapped with 4KB pages.  With 2MB pages, a 64MB table needs
+ * only 32 TLB entries.
+ *
+ * hashtab and slist keep their storage inline, so the way to put
+ * them on huge pages is to allocate the whole container there with
+ * make_huge.  Containers that allocate through an Allocator
+ * (forward_vec, assoc_vec) can use huge_page_allocator instead.
+ *
+ * We first ask for pages from the reserved hugetlbfs pool
+ * (MAP_HUGETLB).  That pool is usually empty, in which case we map a
+ * 2MB-aligned region and mark it with MADV_HUGEPAGE, so that the
+ * kernel backs it with transparent huge pages.  Requests smaller
+ * than a huge page go to posix_memalign, aligned to a cache line, so
+ * that make_huge can also hold line-aligned types, such as an slist
+ * with slist_block_layout.  */
+
+#ifndef _HUGE_PAGES_H_
+#define _HUGE_PAGES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <utility>
+#include <sys/mman.h>
+
+static const size_t huge_page_size = 2 * 1024 * 1024;
+static const size_t huge_small_align = 64;
+
+namespace huge_pages_detail
+{
+  inline size_t
+  round_up (size_t size)
+  {
+    return (size + huge_page_size - 1) & ~(huge_page_size - 1);
+  }
+}
+
+inline void *
+huge_alloc (size_t size)
+{
+  if (size < huge_page_size)
+    {
+      void *p;
+      if (posix_memalign (&p, huge_small_align, size))
+	throw std::bad_alloc ();
+      return p;
+    }
+
+  size = huge_pages_detail::round_up (size);
+  int const prot = PROT_READ | PROT_WRITE;
+  int const flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#ifdef MAP_HUGETLB
+  void *p = mmap (NULL, size, prot, flags | MAP_HUGETLB, -1, 0);
+  if (p != MAP_FAILED)
+    return p;
+#endif
+
+  // Transparent huge pages are only used for aligned 2MB ranges, so
+  // over-allocate and trim both ends.
+  size_t len = size + huge_page_size;
+  void *raw = mmap (NULL, len, prot, flags, -1, 0);
+  if (raw == MAP_FAILED)
+    throw std::bad_alloc ();
+
+  uintptr_t begin = uintptr_t (raw);
+  uintptr_t aligned = (begin + huge_page_size - 1) & ~(huge_page_size - 1);
+  if (aligned != begin)
+    munmap (raw, aligned - begin);
+  if (aligned + size != begin + len)
+    munmap ((void *)(aligned + size), begin + len - (aligned + size));
+
+#ifdef MADV_HUGEPAGE
+  madvise ((void *)aligned, size, MADV_HUGEPAGE);
+#endif
+  return (void *)aligned;
+}
+
+// SIZE has to be the same as was passed to huge_alloc.
+inline void
+huge_free (void *p, size_t size)
+{
+  if (size < huge_page_size)
+    free (p);
+  else
+    munmap (p, huge_pages_detail::round_up (size));
+}
+
+template <class T>
+struct huge_page_allocator
+{
+  typedef T value_type;
+
+  huge_page_allocator ()
+  {}
+
+  template <class U>
+  huge_page_allocator (huge_page_allocator<U> const &)
+  {}
+
+  T *
+  allocate (size_t n)
+  {
+    return static_cast<T *> (huge_alloc (n * sizeof (T)));
+  }
+
+  void
+  deallocate (T *p, size_t n)
+  {
+    huge_free (p, n * sizeof (T));
+  }
+};
+
+template <class T, class U>
+bool
+operator == (huge_page_allocator<T> const &, huge_page_allocator<U> const &)
+{
+  return true;
+}
+
+template <class T, class U>
+bool
+operator != (huge_page_allocator<T> const &, huge_page_allocator<U> const &)
+{
+  return false;
+}
+
+template <class T>
+struct huge_deleter
+{
+  void
+  operator () (T *p) const
+  {
+    p->~T ();
+    huge_free (p, sizeof (T));
+  }
+};
+
+template <class T>
+using huge_ptr = std::unique_ptr<T, huge_deleter<T>>;
+
+// Construct a T in memory backed by huge pages.
+template <class T, class... Args>
+huge_ptr<T>
+make_huge (Args &&... args)
+{
+  static_assert (alignof (T) <= huge_small_align, "T is over-aligned");
+  void *p = huge_alloc (sizeof (T));
+  try
+    {
+      return huge_ptr<T> (new (p) T (std::forward<Args> (args)...));
+    }
+  catch (...)
+    {
+      huge_free (p, sizeof (T));
+      throw;
+    }
+}
+
+#endif /* _HUGE_PAGES_H_ */
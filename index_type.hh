@@ -0,0 +1,38 @@
+/*
+ * Choice of integer type for slot indices.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INDEX_TYPE_H_
+#define _INDEX_TYPE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// The smallest unsigned type that holds all of 0..N, so that N itself
+// is available as a "no slot" marker.
+template <size_t N>
+struct index_type_for
+{
+  typedef typename std::conditional<(N < 256), uint8_t,
+    typename std::conditional<(N < 65536), uint16_t,
+      typename std::conditional<(N < 4294967296ULL), uint32_t,
+				size_t>::type>::type>::type type;
+};
+
+#endif /* _INDEX_TYPE_H_ */
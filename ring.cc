@@ -0,0 +1,229 @@
+/*
+ * Test suite for fixed-size lock-free ring buffers.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ring.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum { nthreads = 4 };
+
+template <size_t N, class Mode>
+void
+single_thread_tests ()
+{
+  std::cout << std::endl << " + single thread " << typeid (Mode).name ()
+	    << " N=" << N << " " << std::flush;
+  ring_ptr<std::string, N, Mode> r (make_ring<std::string, N, Mode> ());
+  assert (uintptr_t (r.get ()) % 64 == 0);
+  assert (r->empty ());
+
+  // Go around a few times, so that the positions wrap.
+  std::cout << "0" << std::flush;
+  std::string v;
+  for (size_t round = 0; round < 3; ++round)
+    {
+      for (size_t i = 0; i < N; ++i)
+	assert (r->try_push (std::to_string (i)));
+      assert (!r->try_push ("x"));
+      assert (!r->empty ());
+      for (size_t i = 0; i < N; ++i)
+	{
+	  assert (r->try_pop (v));
+	  assert (v == std::to_string (i));
+	}
+      assert (!r->try_pop (v));
+      assert (r->empty ());
+    }
+
+  // Batches stop where the ring is full or empty.
+  std::cout << "1" << std::flush;
+  std::vector<std::string> in, out (N + 3);
+  for (size_t i = 0; i < N + 3; ++i)
+    in.push_back (std::to_string (i * 7));
+  assert (r->try_push ("first"));
+  assert (r->push_batch (in.begin (), N + 3) == N - 1);
+  assert (r->push_batch (in.begin (), 1) == 0);
+  assert (r->try_pop (v) && v == "first");
+  assert (r->pop_batch (out.begin (), N / 2) == N / 2);
+  assert (r->pop_batch (out.begin () + N / 2, N + 3) == N - 1 - N / 2);
+  for (size_t i = 0; i < N - 1; ++i)
+    assert (out[i] == in[i]);
+  assert (r->pop_batch (out.begin (), 1) == 0);
+
+  // Leave some elements in, for the destructor.
+  std::cout << "2" << std::flush;
+  for (size_t i = 0; i < N / 2; ++i)
+    r->try_push (std::string (100, 'a'));
+}
+
+// One producer sends increasing numbers, partly in batches, and the
+// consumer checks that they arrive in order.  Both yield when they
+// can't go on, so that the test doesn't crawl on a single CPU.
+template <size_t N>
+void
+spsc_stress ()
+{
+  std::cout << std::endl << " + spsc stress N=" << N << " " << std::flush;
+  enum { count = 2000000 };
+  ring_ptr<int, N, ring_spsc> r (make_ring<int, N, ring_spsc> ());
+
+  std::thread producer ([&r] ()
+    {
+      int buf[16];
+      for (int i = 0; i < count; )
+	if (i % 3 == 0)
+	  {
+	    if (r->try_push (i))
+	      ++i;
+	    else
+	      std::this_thread::yield ();
+	  }
+	else
+	  {
+	    int n = std::min (16, count - i);
+	    for (int j = 0; j < n; ++j)
+	      buf[j] = i + j;
+	    if (size_t k = r->push_batch (buf, n))
+	      i += k;
+	    else
+	      std::this_thread::yield ();
+	  }
+    });
+
+  int expect = 0;
+  int buf[16];
+  while (expect < count)
+    if (expect % 2 == 0)
+      {
+	int v;
+	if (r->try_pop (v))
+	  assert (v == expect++);
+	else
+	  std::this_thread::yield ();
+      }
+    else
+      {
+	size_t n = r->pop_batch (buf, 16);
+	for (size_t j = 0; j < n; ++j)
+	  assert (buf[j] == expect++);
+	if (n == 0)
+	  std::this_thread::yield ();
+      }
+  producer.join ();
+  assert (r->empty ());
+  std::cout << "ok" << std::flush;
+}
+
+// Each producer sends its own numbers in order.  In the end, every
+// number has to arrive exactly once, and each consumer has to see
+// the numbers of each producer in order.
+template <size_t N>
+void
+mpmc_stress ()
+{
+  std::cout << std::endl << " + mpmc stress N=" << N << " " << std::flush;
+  enum { count = 500000 };
+  ring_ptr<int, N, ring_mpmc> r (make_ring<int, N, ring_mpmc> ());
+  std::atomic<int> done (0);
+  std::vector<std::vector<int>> got (nthreads);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nthreads; ++t)
+    {
+      threads.push_back (std::thread ([&r, &done, t] ()
+	{
+	  int buf[8];
+	  for (int i = 0; i < count; )
+	    if (i % 2 == 0)
+	      {
+		if (r->try_push (t * count + i))
+		  ++i;
+		else
+		  std::this_thread::yield ();
+	      }
+	    else
+	      {
+		int n = std::min (8, count - i);
+		for (int j = 0; j < n; ++j)
+		  buf[j] = t * count + i + j;
+		if (size_t k = r->push_batch (buf, n))
+		  i += k;
+		else
+		  std::this_thread::yield ();
+	      }
+	  ++done;
+	}));
+      threads.push_back (std::thread ([&r, &done, &got, t] ()
+	{
+	  int buf[8];
+	  for (;;)
+	    {
+	      bool finished = done == nthreads;
+	      size_t n = r->pop_batch (buf, t % 2 ? 8 : 1);
+	      got[t].insert (got[t].end (), buf, buf + n);
+	      if (n == 0 && finished)
+		break;
+	      if (n == 0)
+		std::this_thread::yield ();
+	    }
+	}));
+    }
+  for (auto it = threads.begin (); it != threads.end (); ++it)
+    it->join ();
+
+  std::vector<char> seen (nthreads * count, 0);
+  for (int t = 0; t < nthreads; ++t)
+    {
+      std::vector<int> last (nthreads, -1);
+      for (auto it = got[t].begin (); it != got[t].end (); ++it)
+	{
+	  assert (!seen[*it]);
+	  seen[*it] = 1;
+	  assert (*it > last[*it / count]);
+	  last[*it / count] = *it;
+	}
+    }
+  for (auto it = seen.begin (); it != seen.end (); ++it)
+    assert (*it);
+  std::cout << "ok" << std::flush;
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::cout << "running ring tests" << std::flush;
+  single_thread_tests<1, ring_spsc> ();
+  single_thread_tests<16, ring_spsc> ();
+  single_thread_tests<1024, ring_spsc> ();
+  single_thread_tests<2, ring_mpmc> ();
+  single_thread_tests<16, ring_mpmc> ();
+  single_thread_tests<1024, ring_mpmc> ();
+  spsc_stress<16> ();
+  spsc_stress<4096> ();
+  mpmc_stress<16> ();
+  mpmc_stress<4096> ();
+  std::cout << std::endl;
+}
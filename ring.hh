@@ -0,0 +1,457 @@
+/*
+ * Implementation of fixed-size lock-free ring buffers.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A bounded FIFO queue of N elements, N a power of two, allocated in
+ * place like slist.  Head and tail are free-running counters, and the
+ * cell of a position is the counter modulo N, so the counters never
+ * need to be wrapped by hand.
+ *
+ * ring<T, N, ring_spsc> is for one producer and one consumer thread.
+ * Each side owns one counter and only reads the other one, and each
+ * keeps a private copy of the other's counter, which it refreshes
+ * only when the copy says the ring is full (or empty).  Both push and
+ * pop are wait-free.
+ *
+ * ring<T, N, ring_mpmc> takes any number of producers and consumers.
+ * Each cell has a sequence number that says whose turn it is: the
+ * cell of position P is free for the producer of P when the sequence
+ * is P, and holds a value for the consumer of P when it is P + 1.
+ * Threads claim positions by compare-and-swap on the counters, and
+ * publish the cell by storing the next sequence.  This is lock-free,
+ * but a thread that's preempted between claiming a cell and
+ * publishing it holds up those that come after it.
+ *
+ * In both, the counters are aligned to cache lines of their own, so
+ * that producers and consumers don't invalidate each other's lines.
+ * That makes the ring over-aligned, which operator new doesn't honor
+ * before C++17, so put rings on the heap with make_ring.
+ * Batched push and pop move as many elements as there's room (or
+ * elements) for, up to the requested count, and touch the shared
+ * counters once per batch.
+ *
+ * No thread may use the ring while it's being destroyed.  */
+
+#ifndef _RING_H_
+#define _RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+struct ring_spsc {};
+struct ring_mpmc {};
+
+namespace ring_detail
+{
+  enum { line_size = 64 };
+
+  // An atomic counter on a cache line of its own, together with
+  // EXTRA data that whoever writes the counter wants to keep close.
+  template <class Extra = char>
+  struct alignas (line_size) padded_counter
+  {
+    std::atomic<size_t> value;
+    Extra extra;
+
+    padded_counter ()
+      : value (0)
+      , extra ()
+    {}
+  };
+
+  template <class T>
+  struct alignas (T) slot
+  {
+    unsigned char bytes[sizeof (T)]; // payload
+
+    T &
+    payload ()
+    {
+      return *reinterpret_cast<T *> (bytes);
+    }
+  };
+}
+
+template<class T, size_t N, class Mode = ring_spsc>
+class ring;
+
+template<class T, size_t N>
+class ring<T, N, ring_spsc>
+{
+  static_assert (N > 0 && (N & (N - 1)) == 0, "N has to be a power of two");
+
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+
+private:
+  typedef ring_detail::padded_counter<size_t> counter;
+
+  ring_detail::slot<T> _slots[N];
+  // Written by the consumer, with its copy of the tail.
+  counter _head;
+  // Written by the producer, with its copy of the head.
+  counter _tail;
+
+  T &
+  payload (size_t pos)
+  {
+    return _slots[pos & (N - 1)].payload ();
+  }
+
+  // Answer how many of WANT cells the producer may fill, from T on.
+  size_t
+  room (size_t t, size_t want)
+  {
+    size_t n = N - (t - _tail.extra);
+    if (n < want)
+      {
+	_tail.extra = _head.value.load (std::memory_order_acquire);
+	n = N - (t - _tail.extra);
+      }
+    return n < want ? n : want;
+  }
+
+  // Answer how many of WANT cells the consumer may empty, from H on.
+  size_t
+  ready (size_t h, size_t want)
+  {
+    size_t n = _head.extra - h;
+    if (n < want)
+      {
+	_head.extra = _tail.value.load (std::memory_order_acquire);
+	n = _head.extra - h;
+      }
+    return n < want ? n : want;
+  }
+
+public:
+  ring () {}
+  ring (ring const &) = delete;
+  ring &operator = (ring const &) = delete;
+
+  ~ring ()
+  {
+    size_t t = _tail.value.load (std::memory_order_relaxed);
+    for (size_t h = _head.value.load (std::memory_order_relaxed); h != t; ++h)
+      payload (h).~T ();
+  }
+
+  // Producer only.  Answer false if the ring is full.
+  template <class... Args>
+  bool
+  try_emplace (Args &&... args)
+  {
+    size_t t = _tail.value.load (std::memory_order_relaxed);
+    if (room (t, 1) == 0)
+      return false;
+    new (&payload (t)) T (std::forward<Args> (args)...);
+    _tail.value.store (t + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool
+  try_push (T const &value)
+  {
+    return try_emplace (value);
+  }
+
+  bool
+  try_push (T &&value)
+  {
+    return try_emplace (std::move (value));
+  }
+
+  // Producer only.  Copy up to COUNT elements from FIRST and answer
+  // how many there were room for.
+  template <class InputIterator>
+  size_t
+  push_batch (InputIterator first, size_t count)
+  {
+    size_t t = _tail.value.load (std::memory_order_relaxed);
+    size_t n = room (t, count);
+    for (size_t i = 0; i < n; ++i, ++first)
+      new (&payload (t + i)) T (*first);
+    _tail.value.store (t + n, std::memory_order_release);
+    return n;
+  }
+
+  // Consumer only.  Move the front element to VALUE and answer true,
+  // or answer false if the ring is empty.
+  bool
+  try_pop (T &value)
+  {
+    size_t h = _head.value.load (std::memory_order_relaxed);
+    if (ready (h, 1) == 0)
+      return false;
+    value = std::move (payload (h));
+    payload (h).~T ();
+    _head.value.store (h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only.  Move up to COUNT elements to OUT and answer how
+  // many there were.
+  template <class OutputIterator>
+  size_t
+  pop_batch (OutputIterator out, size_t count)
+  {
+    size_t h = _head.value.load (std::memory_order_relaxed);
+    size_t n = ready (h, count);
+    for (size_t i = 0; i < n; ++i, ++out)
+      {
+	*out = std::move (payload (h + i));
+	payload (h + i).~T ();
+      }
+    _head.value.store (h + n, std::memory_order_release);
+    return n;
+  }
+
+  // This is only a snapshot, the other side may change it right away.
+  bool
+  empty () const
+  {
+    return _head.value.load (std::memory_order_acquire)
+      == _tail.value.load (std::memory_order_acquire);
+  }
+
+  size_type
+  capacity () const
+  {
+    return N;
+  }
+};
+
+template<class T, size_t N>
+class ring<T, N, ring_mpmc>
+{
+  static_assert (N > 0 && (N & (N - 1)) == 0, "N has to be a power of two");
+  // With one cell, a full cell would look free to the next producer.
+  static_assert (N >= 2, "N has to be at least two");
+
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+
+private:
+  typedef ring_detail::padded_counter<> counter;
+
+  struct cell
+  {
+    std::atomic<size_t> seq;
+    ring_detail::slot<T> slot;
+  };
+
+  cell _cells[N];
+  counter _head;
+  counter _tail;
+
+  cell &
+  cell_at (size_t pos)
+  {
+    return _cells[pos & (N - 1)];
+  }
+
+  // Claim up to WANT positions of COUNTER whose cells have the
+  // sequence position + LAG.  Answer the first position and set WANT
+  // to the number claimed, which is zero if the first cell isn't
+  // ready yet.
+  size_t
+  claim (counter &ctr, size_t lag, size_t &want)
+  {
+    size_t pos = ctr.value.load (std::memory_order_relaxed);
+    for (;;)
+      {
+	size_t n = 0;
+	while (n < want)
+	  {
+	    size_t seq = cell_at (pos + n).seq.load (std::memory_order_acquire);
+	    intptr_t dif = intptr_t (seq) - intptr_t (pos + n + lag);
+	    if (dif != 0)
+	      {
+		// Another thread got to the first cell first.
+		if (n == 0 && dif > 0)
+		  {
+		    pos = ctr.value.load (std::memory_order_relaxed);
+		    continue;
+		  }
+		break;
+	      }
+	    ++n;
+	  }
+	if (n == 0
+	    || ctr.value.compare_exchange_weak (pos, pos + n,
+						std::memory_order_relaxed))
+	  {
+	    want = n;
+	    return pos;
+	  }
+      }
+  }
+
+public:
+  ring ()
+  {
+    for (size_t i = 0; i < N; ++i)
+      _cells[i].seq.store (i, std::memory_order_relaxed);
+  }
+
+  ring (ring const &) = delete;
+  ring &operator = (ring const &) = delete;
+
+  ~ring ()
+  {
+    size_t t = _tail.value.load (std::memory_order_relaxed);
+    for (size_t h = _head.value.load (std::memory_order_relaxed); h != t; ++h)
+      cell_at (h).slot.payload ().~T ();
+  }
+
+  // Answer false if the ring is full.
+  template <class... Args>
+  bool
+  try_emplace (Args &&... args)
+  {
+    size_t n = 1;
+    size_t pos = claim (_tail, 0, n);
+    if (n == 0)
+      return false;
+    cell &c = cell_at (pos);
+    new (c.slot.bytes) T (std::forward<Args> (args)...);
+    c.seq.store (pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool
+  try_push (T const &value)
+  {
+    return try_emplace (value);
+  }
+
+  bool
+  try_push (T &&value)
+  {
+    return try_emplace (std::move (value));
+  }
+
+  // Copy up to COUNT elements from FIRST and answer how many there
+  // were room for.
+  template <class InputIterator>
+  size_t
+  push_batch (InputIterator first, size_t count)
+  {
+    size_t pos = claim (_tail, 0, count);
+    for (size_t i = 0; i < count; ++i, ++first)
+      {
+	cell &c = cell_at (pos + i);
+	new (c.slot.bytes) T (*first);
+	c.seq.store (pos + i + 1, std::memory_order_release);
+      }
+    return count;
+  }
+
+  // Move the front element to VALUE and answer true, or answer false
+  // if the ring is empty.
+  bool
+  try_pop (T &value)
+  {
+    size_t n = 1;
+    size_t pos = claim (_head, 1, n);
+    if (n == 0)
+      return false;
+    cell &c = cell_at (pos);
+    value = std::move (c.slot.payload ());
+    c.slot.payload ().~T ();
+    c.seq.store (pos + N, std::memory_order_release);
+    return true;
+  }
+
+  // Move up to COUNT elements to OUT and answer how many there were.
+  template <class OutputIterator>
+  size_t
+  pop_batch (OutputIterator out, size_t count)
+  {
+    size_t pos = claim (_head, 1, count);
+    for (size_t i = 0; i < count; ++i, ++out)
+      {
+	cell &c = cell_at (pos + i);
+	*out = std::move (c.slot.payload ());
+	c.slot.payload ().~T ();
+	c.seq.store (pos + i + N, std::memory_order_release);
+      }
+    return count;
+  }
+
+  // This is only a snapshot, other threads may change it right away.
+  bool
+  empty () const
+  {
+    return _head.value.load (std::memory_order_acquire)
+      == _tail.value.load (std::memory_order_acquire);
+  }
+
+  size_type
+  capacity () const
+  {
+    return N;
+  }
+};
+
+namespace ring_detail
+{
+  template <class R>
+  struct deleter
+  {
+    void
+    operator () (R *r) const
+    {
+      r->~R ();
+      std::free (r);
+    }
+  };
+}
+
+template<class T, size_t N, class Mode = ring_spsc>
+using ring_ptr = std::unique_ptr<ring<T, N, Mode>,
+				 ring_detail::deleter<ring<T, N, Mode>>>;
+
+// Construct a ring on the heap, aligned to a cache line.
+template<class T, size_t N, class Mode = ring_spsc>
+ring_ptr<T, N, Mode>
+make_ring ()
+{
+  void *p;
+  if (posix_memalign (&p, ring_detail::line_size, sizeof (ring<T, N, Mode>)))
+    throw std::bad_alloc ();
+  try
+    {
+      return ring_ptr<T, N, Mode> (new (p) ring<T, N, Mode> ());
+    }
+  catch (...)
+    {
+      std::free (p);
+      throw;
+    }
+}
+
+#endif /* _RING_H_ */
@@ -1,11 +1,22 @@
 #include "slist.hh"
+#include "chunked_slist.hh"
 #include "forward_vec.hh"
+#include "gap_list.hh"
+#include "unrolled_list.hh"
+#include "hashers.hh"
+#include "huge_pages.hh"
 #include "tests.hh"
 
+#include <algorithm>
 #include <iostream>
 #include <cstddef>
 #include <forward_list>
+#include <iterator>
+#include <memory>
 #include <cassert>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 template <class H, int M>
 void
@@ -70,7 +81,7 @@ tests (char const *msg = "")
       }
 
       {
-	H *h2 = new H (h);
+	huge_ptr<H> h2 = make_huge<H> (h);
 	for (size_t i = 1; i < M; ++i)
 	  {
 	    if (i % 1000 == 0)
@@ -90,7 +101,6 @@ tests (char const *msg = "")
 	      }
 	    assert (*h2 == h);
 	  }
-	delete h2;
       }
 
       std::cout << "2" << std::flush;
@@ -212,12 +222,787 @@ test_overfill ()
   assert (ok);
 }
 
+// Slots come from the free list first, then from the never used
+// tail of the array.
+template <int N>
+void
+slot_reuse_tests ()
+{
+  std::cout << " + slot reuse " << std::flush;
+  slist<int, N> h;
+  for (int i = 0; i < N / 2; ++i)
+    h.push_front (i);
+  for (int i = 0; i < N / 4; ++i)
+    h.pop_front ();
+  int size = N / 2 - N / 4;
+  for (; size < N; ++size)
+    h.push_front (size);
+
+  bool thrown = false;
+  try
+    {
+      h.push_front (0);
+    }
+  catch (std::bad_alloc const &e)
+    {
+      thrown = true;
+    }
+  assert (thrown);
+
+  slist<int, N> h2 = h;
+  assert (h2 == h);
+  h.clear ();
+  assert (h.empty ());
+  for (int i = 0; i < N; ++i)
+    h.push_front (i);
+  assert (std::distance (h.begin (), h.end ()) == N);
+  assert (std::distance (h2.begin (), h2.end ()) == N);
+
+  int ct = 0;
+  {
+    slist<D, N> d;
+    D one (&ct);
+    for (int i = 0; i < N / 2; ++i)
+      d.push_front (one);
+    d.clear ();
+    assert (ct == N / 2);
+    d.push_front (one);
+  }
+  assert (ct == N / 2 + 2);
+  std::cout << std::endl;
+}
+
+// Counts copies, and whether it was moved from.
+struct M
+{
+  static int copies;
+  std::unique_ptr<int> p;
+
+  explicit M (int i) : p (new int (i)) {}
+  M (M const &other) : p (new int (*other.p)) { ++copies; }
+  M (M &&other) = default;
+  M &operator = (M &&other) = default;
+};
+
+int M::copies = 0;
+
+template <int N>
+void
+move_tests ()
+{
+  std::cout << " + move " << std::flush;
+  M::copies = 0;
+  slist<M, N> h;
+  h.emplace_front (1);
+  M m (0);
+  if (N > 1)
+    {
+      h.push_front (std::move (m));
+      assert (!m.p);
+      assert (*h.front ().p == 0);
+      auto it = h.emplace_after (h.begin (), 2);
+      assert (*it->p == 2);
+    }
+
+  slist<M, N> h2 (std::move (h));
+  assert (h.empty ());
+  assert (*h2.front ().p == (N > 1 ? 0 : 1));
+  h.emplace_front (3);
+  h = std::move (h2);
+  assert (*h.front ().p == (N > 1 ? 0 : 1));
+  assert (M::copies == 0);
+
+  // Move-only payloads.
+  slist<std::unique_ptr<int>, N> u;
+  u.emplace_front (new int (5));
+  std::unique_ptr<int> five (new int (5));
+  u.pop_front ();
+  u.push_front (std::move (five));
+  slist<std::unique_ptr<int>, N> u2 (std::move (u));
+  assert (**u2.begin () == 5);
+  std::cout << std::endl;
+}
+
+template <class H, class L>
+bool
+same (H const &h, L const &l)
+{
+  return std::distance (h.begin (), h.end ()) == std::distance (l.begin (), l.end ())
+    && std::equal (h.begin (), h.end (), l.begin ());
+}
+
+// Compare the relinking operations with std::forward_list.
+template <int N>
+void
+relink_tests ()
+{
+  std::cout << " + relink " << std::flush;
+  typedef std::pair<int, int> P;
+  struct first_less
+  {
+    bool
+    operator () (P const &a, P const &b) const
+    {
+      return a.first < b.first;
+    }
+  };
+
+  std::vector<P> vals;
+  for (int i = 0; i < N / 4; ++i)
+    vals.push_back (P ((i * 7919) % 13, i));
+
+  slist<P, N> h (vals.begin (), vals.end ());
+  std::forward_list<P> l (vals.begin (), vals.end ());
+  h.reverse ();
+  l.reverse ();
+  assert (same (h, l));
+
+  // Stability shows in the second members.
+  h.sort (first_less ());
+  l.sort (first_less ());
+  assert (same (h, l));
+  h.sort ();
+  l.sort ();
+  assert (same (h, l));
+
+  slist<P, N> h2 (vals.begin (), vals.end ());
+  std::forward_list<P> l2 (vals.begin (), vals.end ());
+  h2.sort (first_less ());
+  l2.sort (first_less ());
+  h.sort (first_less ());
+  l.sort (first_less ());
+  h.merge (h2, first_less ());
+  l.merge (l2, first_less ());
+  assert (h2.empty ());
+  assert (same (h, l));
+
+  // A merge that runs out of slots leaves every element on one of the
+  // two lists, both still sorted.
+  if (N >= 8)
+    {
+      slist<int, N> a, b;
+      for (int i = N - 2; i > 0; --i)
+	a.push_front (2 * i);
+      for (int i = 4; i >= 0; --i)
+	b.push_front (4 * i + 1);
+      bool thrown = false;
+      try
+	{
+	  a.merge (b);
+	}
+      catch (std::bad_alloc const &e)
+	{
+	  thrown = true;
+	}
+      assert (thrown);
+      std::vector<int> all (a.begin (), a.end ());
+      assert (std::is_sorted (all.begin (), all.end ()));
+      assert (std::is_sorted (b.begin (), b.end ()));
+      all.insert (all.end (), b.begin (), b.end ());
+      assert (all.size () == size_t (N - 2 + 5));
+    }
+
+  if (N >= 16)
+    {
+      // Within one list.
+      auto hi = h.begin (), hj = h.begin ();
+      auto li = l.begin (), lj = l.begin ();
+      std::advance (hj, 2);
+      std::advance (lj, 2);
+      h.splice_after (hj, h, hi);
+      l.splice_after (lj, l, li);
+      assert (same (h, l));
+      h.splice_after (h.begin (), h, hj, h.end ());
+      l.splice_after (l.begin (), l, lj, l.end ());
+      assert (same (h, l));
+
+      // From other lists.
+      slist<P, N> h3;
+      std::forward_list<P> l3;
+      for (int i = 0; i < 3; ++i)
+	{
+	  h3.push_front (P (-i, i));
+	  l3.push_front (P (-i, i));
+	}
+      h3.pop_front ();
+      l3.pop_front ();
+      h3.push_front (P (100, 100));
+      l3.push_front (P (100, 100));
+      h.pop_front ();
+      l.pop_front ();
+      h.pop_front ();
+      l.pop_front ();
+
+      h.splice_after (h.begin (), h3, h3.begin ());
+      l.splice_after (l.begin (), l3, l3.begin ());
+      assert (same (h, l) && same (h3, l3));
+      h.splice_after (h.begin (), h3);
+      l.splice_after (l.begin (), l3);
+      assert (same (h, l) && same (h3, l3));
+      h3.push_front (P (7, 7));
+      l3.push_front (P (7, 7));
+      h3.push_front (P (8, 8));
+      l3.push_front (P (8, 8));
+      h.erase_after (h.begin ());
+      l.erase_after (l.begin ());
+      h.splice_after (h.begin (), h3, h3.begin (), h3.end ());
+      l.splice_after (l.begin (), l3, l3.begin (), l3.end ());
+      assert (same (h, l) && same (h3, l3));
+    }
+  std::cout << std::endl;
+}
+
+// Compact a churned list, in steps and at once.
+template <int N>
+void
+compact_tests ()
+{
+  std::cout << " + compact " << std::flush;
+  slist<std::string, N> h;
+  std::forward_list<std::string> l;
+  for (int i = 0; i < N; ++i)
+    {
+      h.push_front (std::to_string (i));
+      l.push_front (std::to_string (i));
+    }
+  // Drop every other element, then fill some of the holes again.
+  for (auto it = h.begin (); it != h.end () && std::next (it) != h.end (); ++it)
+    h.erase_after (it);
+  for (auto it = l.begin (); it != l.end () && std::next (it) != l.end (); ++it)
+    l.erase_after (it);
+  for (int i = 0; i < N / 8; ++i)
+    {
+      h.push_front (std::string (50, 'a' + i % 26));
+      l.push_front (std::string (50, 'a' + i % 26));
+    }
+  assert (same (h, l));
+  if (N > 4)
+    assert (h.locality () < 1);
+
+  size_t moved;
+  do
+    {
+      moved = h.compact (N / 16 + 1);
+      assert (same (h, l));
+    }
+  while (moved > 0);
+  assert (h.locality () == 1);
+
+  // The free slots are all past the elements now.
+  size_t n = std::distance (l.begin (), l.end ());
+  for (size_t i = n; i < size_t (N); ++i)
+    {
+      h.push_front ("x");
+      l.push_front ("x");
+    }
+  assert (same (h, l));
+  h.compact ();
+  assert (same (h, l));
+  assert (h.locality () == 1);
+
+  // Compacting an empty list is a no-op.
+  h.clear ();
+  assert (h.compact () == 0);
+  assert (h.empty ());
+  std::cout << std::endl;
+}
+
 template <class T, int N>
 struct slistC
 {
   typedef slist<T, N> type;
 };
 
+template <class T, int N>
+struct slist_nodeC
+{
+  typedef slist<T, N, slist_node_layout> type;
+};
+
+template <class T, int N>
+struct slist_blockC
+{
+  typedef slist<T, N, slist_block_layout> type;
+};
+
+template <class T, int N>
+struct chunkedC
+{
+  typedef chunked_slist<T, 64> type;
+};
+
+// Limited to N elements.
+template <class T, int N>
+struct chunked_boundedC
+{
+  typedef chunked_slist<T, 16, N> type;
+};
+
+// Growing doesn't move elements, and swap doesn't either.
+template <int N>
+void
+chunked_tests ()
+{
+  std::cout << " + chunked growth " << std::flush;
+  chunked_slist<int, 16> h;
+  std::vector<int const *> addrs;
+  for (int i = 0; i < N; ++i)
+    {
+      h.push_front (i);
+      addrs.push_back (&h.front ());
+    }
+  assert (h.capacity () >= size_t (N) && h.capacity () < size_t (N) + 16);
+
+  chunked_slist<int, 16> h2;
+  swap (h, h2);
+  assert (h.empty ());
+  int i = N;
+  for (auto it = h2.begin (); it != h2.end (); ++it)
+    {
+      --i;
+      assert (*it == i);
+      assert (&*it == addrs[i]);
+    }
+
+  // Chunks are reused after clear.
+  size_t cap = h2.capacity ();
+  h2.clear ();
+  for (int i = 0; i < N; ++i)
+    h2.push_front (i);
+  assert (h2.capacity () == cap);
+
+  chunked_slist<int, 16> h3 (std::move (h2));
+  assert (h2.empty ());
+  assert (std::distance (h3.begin (), h3.end ()) == N);
+  std::cout << std::endl;
+}
+
+// Range edits of forward_vec, compared with std::forward_list.
+template <int N>
+void
+fwdvec_range_tests ()
+{
+  std::cout << " + forward_vec ranges " << std::flush;
+  std::vector<int> vals;
+  for (int i = 0; i < N; ++i)
+    vals.push_back (i);
+
+  forward_vec<int> h (vals.begin (), vals.end ());
+  std::forward_list<int> l (vals.begin (), vals.end ());
+  for (int step = 0; step < 4 && !l.empty (); ++step)
+    {
+      // Erase a run from the middle, not up to the end.
+      int n = std::distance (l.begin (), l.end ());
+      auto hf = h.cbegin (), hl = hf;
+      auto lf = l.cbegin (), ll = lf;
+      std::advance (hf, n / 4);
+      std::advance (lf, n / 4);
+      std::advance (hl, std::min (n, n / 2 + 1));
+      std::advance (ll, std::min (n, n / 2 + 1));
+      auto hr = h.erase_after (hf, hl);
+      auto lr = l.erase_after (lf, ll);
+      assert (same (h, l));
+      assert (std::distance (h.begin (), hr)
+	      == std::distance (l.begin (), lr));
+
+      // Insert a run after the front and after the last element.
+      std::vector<int> more (vals.begin (), vals.begin () + N / 3);
+      auto hi = h.insert_after (h.cbegin (), more.begin (), more.end ());
+      auto li = l.insert_after (l.cbegin (), more.begin (), more.end ());
+      assert (same (h, l));
+      assert (std::distance (h.begin (), hi)
+	      == std::distance (l.begin (), li));
+      hl = h.cbegin ();
+      ll = l.cbegin ();
+      std::advance (hl, std::distance (l.begin (), l.end ()) - 1);
+      std::advance (ll, std::distance (l.begin (), l.end ()) - 1);
+      h.insert_after (hl, size_t (3), -step);
+      l.insert_after (ll, size_t (3), -step);
+      assert (same (h, l));
+    }
+
+  // Shrink and grow in one go.
+  h.resize (N / 2);
+  l.resize (N / 2);
+  assert (same (h, l));
+  h.resize (N, 7);
+  l.resize (N, 7);
+  assert (same (h, l));
+  h.resize (0);
+  assert (h.empty ());
+  h.resize (3, 1);
+  l.assign (3, 1);
+  assert (same (h, l));
+  std::cout << std::endl;
+}
+
+// Edits around a cursor that moves back and forth, compared with
+// std::forward_list.
+template <int N>
+void
+gap_list_tests ()
+{
+  std::cout << " + gap_list cursor " << std::flush;
+  std::vector<std::string> vals;
+  for (int i = 0; i < N; ++i)
+    vals.push_back (std::to_string (i));
+  gap_list<std::string> h (vals.begin (), vals.end ());
+  std::forward_list<std::string> l (vals.begin (), vals.end ());
+
+  size_t cursor = 0, size = N;
+  for (int r = 0; r < 4 * N; ++r)
+    {
+      uint64_t m = mix64 (r);
+      if (m % 7 == 0)
+	cursor = size > 0 ? (m >> 8) % size : 0;
+      if (size == 0)
+	{
+	  h.push_front (vals[r % N]);
+	  l.push_front (vals[r % N]);
+	  ++size;
+	  continue;
+	}
+
+      auto hi = h.begin ();
+      auto li = l.begin ();
+      std::advance (hi, cursor);
+      std::advance (li, cursor);
+      switch ((m >> 4) % 4)
+	{
+	case 0:
+	  hi = h.insert_after (hi, vals[r % N]);
+	  li = l.insert_after (li, vals[r % N]);
+	  assert (*hi == *li);
+	  ++size;
+	  ++cursor;
+	  break;
+	case 1:
+	  if (cursor + 1 < size)
+	    {
+	      h.erase_after (hi);
+	      l.erase_after (li);
+	      --size;
+	    }
+	  break;
+	case 2:
+	  h.push_front (vals[r % N]);
+	  l.push_front (vals[r % N]);
+	  ++size;
+	  break;
+	case 3:
+	  h.pop_front ();
+	  l.pop_front ();
+	  --size;
+	  cursor = cursor > 0 ? cursor - 1 : 0;
+	  break;
+	}
+      if (cursor >= size)
+	cursor = size > 0 ? size - 1 : 0;
+      if (r % 64 == 0)
+	assert (same (h, l));
+    }
+  assert (same (h, l));
+
+  gap_list<std::string> h2 (h);
+  assert (h2 == h);
+  h.resize (size / 2);
+  l.resize (size / 2);
+  assert (same (h, l));
+  h.resize (size, "x");
+  l.resize (size, "x");
+  assert (same (h, l));
+
+  // Values that refer to elements which the gap moves over.
+  if (size >= 2)
+    {
+      h.insert_after (std::next (h.begin ()), "y");
+      l.insert_after (std::next (l.begin ()), "y");
+      h.push_front (h.front ());
+      l.push_front (l.front ());
+      assert (same (h, l));
+      h.insert_after (std::next (h.begin (), size + 1),
+		      *std::next (h.begin ()));
+      l.insert_after (std::next (l.begin (), size + 1),
+		      *std::next (l.begin ()));
+      assert (same (h, l));
+    }
+  std::cout << std::endl;
+}
+
+// Edits at random positions, so that blocks split and merge all over
+// the list, compared with std::forward_list.
+template <class H>
+void
+unrolled_edits (std::vector<typename H::value_type> const &vals)
+{
+  std::cout << " + " << typeid (H).name ()
+	    << " block_size=" << size_t (H::block_size) << " " << std::flush;
+  H h;
+  std::forward_list<typename H::value_type> l;
+  int n = vals.size ();
+
+  size_t size = 0;
+  for (int r = 0; r < 8 * n; ++r)
+    {
+      uint64_t m = mix64 (r);
+      auto const &v = vals[r % n];
+      // Lean towards growing at first and towards shrinking later,
+      // so that the list goes both through mostly full blocks and
+      // through mostly empty ones.
+      bool grow = (m >> 32) % (8 * n) >= size_t (r);
+      if (size == 0 || (m % 8 == 0 && grow))
+	{
+	  h.push_front (v);
+	  l.push_front (v);
+	  ++size;
+	  continue;
+	}
+
+      size_t at = (m >> 8) % size;
+      auto hi = h.begin ();
+      auto li = l.begin ();
+      std::advance (hi, at);
+      std::advance (li, at);
+      if (m % 8 == 0)
+	{
+	  h.pop_front ();
+	  l.pop_front ();
+	  --size;
+	}
+      else if (grow)
+	{
+	  hi = h.insert_after (hi, v);
+	  li = l.insert_after (li, v);
+	  assert (*hi == *li);
+	  ++size;
+	}
+      else if (at + 1 < size)
+	{
+	  size_t k = std::min (size - at - 1, size_t (1 + (m >> 4) % 3));
+	  auto hl = hi;
+	  auto ll = li;
+	  std::advance (hl, k + 1);
+	  std::advance (ll, k + 1);
+	  auto hr = k == 1 ? h.erase_after (hi) : h.erase_after (hi, hl);
+	  auto lr = l.erase_after (li, ll);
+	  assert ((hr == h.end ()) == (lr == l.end ()));
+	  if (hr != h.end ())
+	    assert (*hr == *lr);
+	  // erase_after keeps its argument valid.
+	  assert (*hi == *li);
+	  size -= k;
+	}
+      if (r % 64 == 0)
+	assert (same (h, l));
+    }
+  assert (same (h, l));
+
+  H h2 (h);
+  assert (h2 == h);
+  h.resize (size / 2);
+  l.resize (size / 2);
+  assert (same (h, l));
+  h.resize (size, vals[0]);
+  l.resize (size, vals[0]);
+  assert (same (h, l));
+
+  // Values that refer to elements which the insert moves.
+  if (size >= 2)
+    {
+      h.insert_after (h.begin (), *std::next (h.begin ()));
+      l.insert_after (l.begin (), *std::next (l.begin ()));
+      h.push_front (*std::next (h.begin ()));
+      l.push_front (*std::next (l.begin ()));
+      assert (same (h, l));
+    }
+  std::cout << std::endl;
+}
+
+// The relinking operations of unrolled_list, compared with
+// std::forward_list.
+template <class H>
+void
+unrolled_relinks (int n)
+{
+  std::cout << " + relink " << typeid (H).name ()
+	    << " block_size=" << size_t (H::block_size) << " " << std::flush;
+  typedef std::pair<int, int> P;
+  struct first_less
+  {
+    bool
+    operator () (P const &a, P const &b) const
+    {
+      return a.first < b.first;
+    }
+  };
+
+  std::vector<P> vals;
+  for (int i = 0; i < n; ++i)
+    vals.push_back (P ((i * 7919) % 13, i));
+
+  H h (vals.begin (), vals.end ());
+  std::forward_list<P> l (vals.begin (), vals.end ());
+  h.reverse ();
+  l.reverse ();
+  assert (same (h, l));
+  h.sort (first_less ());
+  l.sort (first_less ());
+  assert (same (h, l));
+  h.sort ();
+  l.sort ();
+  assert (same (h, l));
+
+  std::cout << "0" << std::flush;
+  H h2 (vals.begin (), vals.end ());
+  std::forward_list<P> l2 (vals.begin (), vals.end ());
+  h2.sort (first_less ());
+  l2.sort (first_less ());
+  h.sort (first_less ());
+  l.sort (first_less ());
+  h.merge (h2, first_less ());
+  l.merge (l2, first_less ());
+  assert (h2.empty ());
+  assert (same (h, l));
+
+  // Long runs go over as whole blocks.
+  for (int i = 0; i < n / 2; ++i)
+    {
+      h2.push_front (P (n / 4 + i, -i));
+      l2.push_front (P (n / 4 + i, -i));
+    }
+  h2.reverse ();
+  l2.reverse ();
+  h.sort ();
+  l.sort ();
+  h.merge (h2);
+  l.merge (l2);
+  assert (same (h, l));
+
+  std::cout << "1" << std::flush;
+  H h3 (vals.begin (), vals.end ());
+  std::forward_list<P> l3 (vals.begin (), vals.end ());
+  for (int r = 0; r < 200; ++r)
+    {
+      uint64_t m = mix64 (r);
+      size_t size = std::distance (l.begin (), l.end ());
+      if (size < 2)
+	break;
+      // Move (FIRST, LAST) after AT, which is outside of it.
+      size_t first = m % (size - 1);
+      size_t last = first + 1 + (m >> 8) % (size - first);
+      size_t at = (m >> 16) % (first + 1 + size - last);
+      if (at > first)
+	at += last - first - 1;
+      auto hat = std::next (h.cbegin (), at);
+      auto lat = std::next (l.cbegin (), at);
+      switch ((m >> 24) % 4)
+	{
+	case 0:
+	  h.splice_after (hat, h, std::next (h.cbegin (), first));
+	  l.splice_after (lat, l, std::next (l.cbegin (), first));
+	  break;
+	case 1:
+	  h.splice_after (hat, h, std::next (h.cbegin (), first),
+			  std::next (h.cbegin (), last));
+	  l.splice_after (lat, l, std::next (l.cbegin (), first),
+			  std::next (l.cbegin (), last));
+	  break;
+	case 2:
+	  {
+	    size_t size3 = std::distance (l3.begin (), l3.end ());
+	    if (size3 < 2)
+	      break;
+	    first = (m >> 32) % (size3 - 1);
+	    last = first + 1 + (m >> 40) % (size3 - first);
+	    h.splice_after (hat, h3, std::next (h3.cbegin (), first),
+			    std::next (h3.cbegin (), last));
+	    l.splice_after (lat, l3, std::next (l3.cbegin (), first),
+			    std::next (l3.cbegin (), last));
+	    assert (same (h3, l3));
+	    break;
+	  }
+	case 3:
+	  if (r % 16 == 3)
+	    {
+	      h.splice_after (hat, h3);
+	      l.splice_after (lat, l3);
+	      assert (h3.empty ());
+	      h3 = H (vals.begin (), vals.end ());
+	      l3 = std::forward_list<P> (vals.begin (), vals.end ());
+	    }
+	  break;
+	}
+      assert (same (h, l));
+    }
+
+  // A comparison that throws leaves all the elements in the list.
+  std::cout << "2" << std::flush;
+  struct throwing_less
+  {
+    int *left;
+
+    bool
+    operator () (P const &a, P const &b) const
+    {
+      if ((*left)-- == 0)
+	throw std::runtime_error ("compare");
+      return a < b;
+    }
+  };
+  for (int left = 0; left < 3 * n; left += 1 + n / 8)
+    {
+      H h4 (vals.begin (), vals.end ());
+      int l4 = left;
+      bool thrown = false;
+      try
+	{
+	  h4.sort (throwing_less {&l4});
+	}
+      catch (std::runtime_error const &e)
+	{
+	  thrown = true;
+	}
+      std::vector<P> got (h4.begin (), h4.end ());
+      std::vector<P> want (vals);
+      std::sort (got.begin (), got.end ());
+      std::sort (want.begin (), want.end ());
+      assert (got == want);
+      if (!thrown)
+	assert (std::is_sorted (h4.begin (), h4.end ()));
+    }
+  std::cout << std::endl;
+}
+
+template <int N>
+void
+unrolled_tests ()
+{
+  std::vector<int> ints;
+  std::vector<std::string> strings;
+  for (int i = 0; i < N; ++i)
+    {
+      ints.push_back (i);
+      strings.push_back (std::to_string (i));
+    }
+  unrolled_edits<unrolled_list<int> > (ints);
+  unrolled_edits<unrolled_list<std::string> > (strings);
+  unrolled_edits<unrolled_list<std::string, 128> > (strings);
+  unrolled_relinks<unrolled_list<std::pair<int, int> > > (N);
+  unrolled_relinks<unrolled_list<std::pair<int, int>, 256> > (N);
+}
+
+template <class T, int N>
+struct unrolledC
+{
+  typedef unrolled_list<T> type;
+};
+
+template <class T, int N>
+struct gaplistC
+{
+  typedef gap_list<T> type;
+};
+
 template <class T, int N>
 struct fwdvecC
 {
@@ -232,7 +1017,28 @@ testsuite ()
   tests<std::forward_list<int>, N - 1> ();
   custom_testsuite<slistC, N> ();
   test_overfill<slistC, N> ();
+  slot_reuse_tests<N> ();
+  move_tests<N> ();
+  relink_tests<N> ();
+  compact_tests<N> ();
   custom_testsuite<fwdvecC, N> ();
+  fwdvec_range_tests<N> ();
+  if (N <= 4096)
+    {
+      // The tests are quadratic.  The other layouts and chunked_slist
+      // go through the same code as slist, so don't bother with the
+      // biggest lists.
+      gap_list_tests<N> ();
+      unrolled_tests<N> ();
+      custom_testsuite<slist_nodeC, N> ();
+      custom_testsuite<slist_blockC, N> ();
+      custom_testsuite<chunkedC, N> ();
+      custom_testsuite<gaplistC, N> ();
+      custom_testsuite<unrolledC, N> ();
+    }
+  test_overfill<slist_blockC, N> ();
+  test_overfill<chunked_boundedC, N> ();
+  chunked_tests<N> ();
 }
 
 int
@@ -23,12 +23,245 @@
 
 #include <cassert>
 #include <cstddef>
+#include <cstring>
 #include <memory>
 #include <cinttypes>
 #include <iostream>
+#include <algorithm>
+#include <bitset>
+#include <functional>
+#include <type_traits>
+#include <utility>
 
-template<class T, size_t N>
+#include "index_type.hh"
+
+/* How slist lays out payloads and links in memory.  Each layout has a
+ * storage<T, N, Index> class, which answers the payload bytes and the
+ * link of slot I, and which slist derives from.
+ *
+ * The storage also copies and swaps the payloads or the links of the
+ * first N slots in bulk, which slist uses for trivially copyable
+ * payloads and to carry links over verbatim.  Layouts that keep the
+ * payloads or the links in runs do that with a memcpy per run.
+ *
+ * slist_split_layout keeps all payloads in one array and all links in
+ * another.  Unless the list is in memory order, a walk touches two
+ * cache lines per element, but the links are packed densely and
+ * relinking never touches payloads.
+ *
+ * slist_node_layout puts each link right next to its payload, so that
+ * a walk touches a single line per element.  The node is padded to
+ * the alignment of T though, so for small T the link may cost as much
+ * as the payload.
+ *
+ * slist_block_layout groups as many slots as fit into a cache line,
+ * payloads first and their links after them, so there's no padding
+ * per node, and each line that a walk touches has both.  The blocks
+ * are aligned to lines, which makes the list over-aligned.  operator
+ * new doesn't honor that before C++17, so a list on the heap needs
+ * aligned memory, e.g. from make_huge.  */
+
+struct slist_split_layout
+{
+  template <class T, size_t N, class Index>
+  class storage
+  {
+    struct alignas (T) slot
+    {
+      unsigned char bytes[sizeof (T)]; // payload
+    };
+
+    slot _slots[N];
+    Index _nexts[N];
+
+  public:
+    unsigned char *bytes (size_t i) { return _slots[i].bytes; }
+    unsigned char const *bytes (size_t i) const { return _slots[i].bytes; }
+    Index &link (size_t i) { return _nexts[i]; }
+    Index link (size_t i) const { return _nexts[i]; }
+
+    void
+    copy_links (storage const &from, size_t n)
+    {
+      std::memcpy (_nexts, from._nexts, n * sizeof (Index));
+    }
+
+    void
+    swap_links (storage &other, size_t n)
+    {
+      std::swap_ranges (_nexts, _nexts + n, other._nexts);
+    }
+
+    void
+    copy_payloads (storage const &from, size_t n)
+    {
+      std::memcpy (_slots, from._slots, n * sizeof (slot));
+    }
+
+    void
+    swap_payloads (storage &other, size_t n)
+    {
+      std::swap_ranges (_slots, _slots + n, other._slots);
+    }
+  };
+};
+
+struct slist_node_layout
+{
+  template <class T, size_t N, class Index>
+  class storage
+  {
+    struct alignas (T) node
+    {
+      unsigned char bytes[sizeof (T)]; // payload
+      Index next;
+    };
+
+    node _nodes[N];
+
+  public:
+    unsigned char *bytes (size_t i) { return _nodes[i].bytes; }
+    unsigned char const *bytes (size_t i) const { return _nodes[i].bytes; }
+    Index &link (size_t i) { return _nodes[i].next; }
+    Index link (size_t i) const { return _nodes[i].next; }
+
+    // Payloads and links alternate, so these go slot by slot.
+    void
+    copy_links (storage const &from, size_t n)
+    {
+      for (size_t i = 0; i < n; ++i)
+	_nodes[i].next = from._nodes[i].next;
+    }
+
+    void
+    swap_links (storage &other, size_t n)
+    {
+      for (size_t i = 0; i < n; ++i)
+	std::swap (_nodes[i].next, other._nodes[i].next);
+    }
+
+    void
+    copy_payloads (storage const &from, size_t n)
+    {
+      for (size_t i = 0; i < n; ++i)
+	std::memcpy (_nodes[i].bytes, from._nodes[i].bytes, sizeof (T));
+    }
+
+    void
+    swap_payloads (storage &other, size_t n)
+    {
+      for (size_t i = 0; i < n; ++i)
+	std::swap_ranges (_nodes[i].bytes, _nodes[i].bytes + sizeof (T),
+			  other._nodes[i].bytes);
+    }
+  };
+};
+
+struct slist_block_layout
+{
+  enum { line_size = 64 };
+
+  // The number of slots that fit in a line, but at least one.  A
+  // block has N payloads of SIZE bytes, then N links of LINK bytes,
+  // which are aligned to their size.
+  static constexpr size_t
+  block_slots (size_t size, size_t link, size_t n = line_size)
+  {
+    return n <= 1 || (n * size + link - 1) / link * link + n * link <= line_size
+      ? n : block_slots (size, link, n - 1);
+  }
+
+  template <class T, size_t N, class Index>
+  class storage
+  {
+    enum { B = block_slots (sizeof (T), sizeof (Index)) };
+
+    struct alignas (line_size) block
+    {
+      struct alignas (T) slot
+      {
+	unsigned char bytes[sizeof (T)]; // payload
+      };
+
+      slot slots[B];
+      Index nexts[B];
+    };
+
+    static_assert (B == 1 || sizeof (block) == line_size,
+		   "a block fills one line");
+
+    block _blocks[(N + B - 1) / B];
+
+    // Answer how many of the first N slots are in block K.
+    static size_t
+    run (size_t k, size_t n)
+    {
+      return std::min (size_t (B), n - k * B);
+    }
+
+  public:
+    unsigned char *
+    bytes (size_t i)
+    {
+      return _blocks[i / B].slots[i % B].bytes;
+    }
+
+    unsigned char const *
+    bytes (size_t i) const
+    {
+      return _blocks[i / B].slots[i % B].bytes;
+    }
+
+    Index &
+    link (size_t i)
+    {
+      return _blocks[i / B].nexts[i % B];
+    }
+
+    Index
+    link (size_t i) const
+    {
+      return _blocks[i / B].nexts[i % B];
+    }
+
+    void
+    copy_links (storage const &from, size_t n)
+    {
+      for (size_t k = 0; k * B < n; ++k)
+	std::memcpy (_blocks[k].nexts, from._blocks[k].nexts,
+		     run (k, n) * sizeof (Index));
+    }
+
+    void
+    swap_links (storage &other, size_t n)
+    {
+      for (size_t k = 0; k * B < n; ++k)
+	std::swap_ranges (_blocks[k].nexts, _blocks[k].nexts + run (k, n),
+			  other._blocks[k].nexts);
+    }
+
+    void
+    copy_payloads (storage const &from, size_t n)
+    {
+      for (size_t k = 0; k * B < n; ++k)
+	std::memcpy (_blocks[k].slots, from._blocks[k].slots,
+		     run (k, n) * sizeof (typename block::slot));
+    }
+
+    void
+    swap_payloads (storage &other, size_t n)
+    {
+      for (size_t k = 0; k * B < n; ++k)
+	std::swap_ranges (_blocks[k].slots, _blocks[k].slots + run (k, n),
+			  other._blocks[k].slots);
+    }
+  };
+};
+
+template<class T, size_t N, class Layout = slist_split_layout>
 class slist
+  : protected Layout::template storage<T, N,
+				       typename index_type_for<N>::type>
 {
 public:
   typedef T value_type;
@@ -40,19 +273,20 @@ public:
   typedef const value_type *const_pointer;
 
 protected:
-  typedef typename std::conditional<(N < 256), uint8_t,
-    typename std::conditional<(N < 65536), uint16_t, size_t>::type >::type
-  index_type;
-
-  struct slot
-  {
-    unsigned char bytes[sizeof (T)]; // payload
-  };
+  typedef typename index_type_for<N>::type index_type;
+  typedef typename Layout::template storage<T, N, index_type> storage;
+  using storage::bytes;
+  using storage::link;
+  using storage::copy_links;
+  using storage::swap_links;
+  using storage::copy_payloads;
+  using storage::swap_payloads;
 
-  slot _slots[N];
-  index_type _nexts[N];
+  // Slots from _bump up have never been used, and their links are
+  // not initialized.  _free chains slots that were used and returned.
   index_type _head;
   index_type _free;
+  index_type _bump;
 
   template<class This, class Slist>
   class iterator_builder
@@ -90,7 +324,7 @@ protected:
     operator ++ ()
     {
       assert (_pos != N);
-      _pos = _parent->_nexts[_pos];
+      _pos = _parent->link (_pos);
       return *(This *)this;
     }
 
@@ -127,8 +361,7 @@ public:
     reference
     operator * ()
     {
-      unsigned char *bytes = this->_parent->_slots[this->_pos].bytes;
-      return *reinterpret_cast<pointer> (bytes);
+      return *reinterpret_cast<pointer> (this->_parent->bytes (this->_pos));
     }
 
     pointer
@@ -164,8 +397,8 @@ public:
     const_reference
     operator * ()
     {
-      unsigned char const *bytes = this->_parent->_slots[this->_pos].bytes;
-      return *reinterpret_cast<const_pointer> (bytes);
+      return *reinterpret_cast<const_pointer>
+	(this->_parent->bytes (this->_pos));
     }
 
     const_pointer
@@ -181,9 +414,8 @@ private:
   init ()
   {
     _head = N;
-    _free = 0;
-    for (size_t i = 0; i < N; ++i)
-      _nexts[i] = i + 1;
+    _free = N;
+    _bump = 0;
   }
 
   void
@@ -191,7 +423,7 @@ private:
   {
     index_type i = take_slot (value);
     if (tail != N)
-      _nexts[tail] = i;
+      link (tail) = i;
     tail = i;
   }
 
@@ -202,10 +434,26 @@ public:
     init ();
   }
 
+  // Keep each element at the index it has in COPY, so that the links
+  // can be copied over verbatim.
   slist (slist const &copy)
-    : _head (N)
+    : _head (copy._head)
+    , _free (copy._free)
+    , _bump (copy._bump)
+  {
+    copy_links (copy, _bump);
+    clone_slots (copy, trivial_copy ());
+  }
+
+  // Payloads are moved to the same indices, OTHER is left empty.
+  slist (slist &&other)
+    : _head (other._head)
+    , _free (other._free)
+    , _bump (other._bump)
   {
-    *this = slist (copy.begin (), copy.end ());
+    copy_links (other, _bump);
+    move_slots (other, trivial_copy ());
+    other.init ();
   }
 
   template <class InputIterator>
@@ -218,7 +466,7 @@ public:
     if (tail != N)
       {
 	_head = 0;
-	_nexts[tail] = N;
+	link (tail) = N;
       }
   }
 
@@ -231,19 +479,26 @@ public:
 
   ~slist ()
   {
-    for (auto it = begin (); it != end (); ++it)
-      it->~T ();
+    if (!std::is_trivially_destructible<T>::value)
+      for (auto it = begin (); it != end (); ++it)
+	it->~T ();
   }
 
   void
   swap (slist &other)
   {
-    std::swap (_slots, other._slots);
-    std::swap (_nexts, other._nexts);
+    if (this == &other)
+      return;
+    swap_slots (other, trivial_copy ());
+    index_type used = std::max (_bump, other._bump);
+    swap_links (other, used);
     std::swap (_head, other._head);
     std::swap (_free, other._free);
+    std::swap (_bump, other._bump);
   }
 
+  // Assigning an rvalue moves it into OTHER first, so neither copy
+  // nor move assignment touches slots past the used ones.
   slist &
   operator = (slist other)
   {
@@ -254,8 +509,10 @@ public:
   void
   clear ()
   {
-    slist empty;
-    swap (empty);
+    if (!std::is_trivially_destructible<T>::value)
+      for (auto it = begin (); it != end (); ++it)
+	it->~T ();
+    init ();
   }
 
   void
@@ -283,66 +540,187 @@ public:
   }
 
 private:
+  typedef std::integral_constant<bool, std::is_trivially_copyable<T>::value>
+  trivial_copy;
+
+  reference
+  payload (index_type i)
+  {
+    return *reinterpret_cast<pointer> (bytes (i));
+  }
+
+  const_reference
+  payload (index_type i) const
+  {
+    return *reinterpret_cast<const_pointer> (bytes (i));
+  }
+
+  void
+  clone_slots (slist const &copy, std::true_type)
+  {
+    copy_payloads (copy, _bump);
+  }
+
+  void
+  clone_slots (slist const &copy, std::false_type)
+  {
+    for (index_type i = _head; i != N; i = link (i))
+      new (bytes (i)) T (copy.payload (i));
+  }
+
+  void
+  move_slots (slist &other, std::true_type)
+  {
+    copy_payloads (other, _bump);
+  }
+
+  void
+  move_slots (slist &other, std::false_type)
+  {
+    for (index_type i = _head; i != N; i = link (i))
+      other.relocate_slot (i, *this);
+  }
+
+  void
+  swap_slots (slist &other, std::true_type)
+  {
+    index_type used = std::max (_bump, other._bump);
+    swap_payloads (other, used);
+  }
+
+  // Other types can't be swapped as raw bytes, e.g. std::string may
+  // point into its own body.  Payloads stay at their indices, so that
+  // the links can still be swapped wholesale: indices used by both
+  // lists get their payloads swapped, the rest is moved over.
+  void
+  swap_slots (slist &other, std::false_type)
+  {
+    std::bitset<N> mine;
+    for (index_type i = _head; i != N; i = link (i))
+      mine.set (i);
+
+    for (index_type i = other._head; i != N; i = other.link (i))
+      if (mine[i])
+	{
+	  using std::swap;
+	  swap (payload (i), other.payload (i));
+	  mine.reset (i);
+	}
+      else
+	other.relocate_slot (i, *this);
+
+    for (index_type i = _head; i != N; i = link (i))
+      if (mine[i])
+	relocate_slot (i, other);
+  }
+
+  void
+  relocate_slot (index_type i, slist &to)
+  {
+    new (to.bytes (i)) T (std::move (payload (i)));
+    payload (i).~T ();
+  }
+
   void
   check_space () const
   {
-    if (_free == N)
+    if (_free == N && _bump == N)
       throw std::bad_alloc ();
   }
 
+  template <class... Args>
   index_type
-  take_slot (const T &value)
+  take_slot (Args &&... args)
   {
     check_space ();
-    index_type i = _free;
-    slot &slt = _slots[i];
-    _free = _nexts[i];
-    new (slt.bytes) T (value);
+    index_type i;
+    if (_free != N)
+      {
+	i = _free;
+	_free = link (i);
+      }
+    else
+      i = _bump++;
+    try
+      {
+	new (bytes (i)) T (std::forward<Args> (args)...);
+      }
+    catch (...)
+      {
+	link (i) = _free;
+	_free = i;
+	throw;
+      }
     return i;
   }
 
   void
   return_slot (index_type i)
   {
-    unsigned char *bytes = _slots[i].bytes;
-    T &object = *reinterpret_cast<pointer> (bytes);
-    object.~T ();
-    _nexts[i] = _free;
+    payload (i).~T ();
+    link (i) = _free;
     _free = i;
   }
 
 public:
+  template <class... Args>
   void
-  push_front (const T &value)
+  emplace_front (Args &&... args)
   {
-    index_type i = take_slot (value);
-    _nexts[i] = _head;
+    index_type i = take_slot (std::forward<Args> (args)...);
+    link (i) = _head;
     _head = i;
   }
 
   void
-  insert_after (const_iterator it, const T &value)
+  push_front (const T &value)
+  {
+    emplace_front (value);
+  }
+
+  void
+  push_front (T &&value)
+  {
+    emplace_front (std::move (value));
+  }
+
+  template <class... Args>
+  iterator
+  emplace_after (const_iterator it, Args &&... args)
   {
     assert (it._pos < N);
-    index_type i = take_slot (value);
-    _nexts[i] = _nexts[it._pos];
-    _nexts[it._pos] = i;
+    index_type i = take_slot (std::forward<Args> (args)...);
+    link (i) = link (it._pos);
+    link (it._pos) = i;
+    return iterator (this, i);
+  }
+
+  void
+  insert_after (const_iterator it, const T &value)
+  {
+    emplace_after (it, value);
+  }
+
+  void
+  insert_after (const_iterator it, T &&value)
+  {
+    emplace_after (it, std::move (value));
   }
 
   void
   pop_front ()
   {
     index_type i = _head;
-    _head = _nexts[i];
+    _head = link (i);
     return_slot (i);
   }
 
   iterator
   erase_after (const_iterator it)
   {
-    index_type next = _nexts[it._pos];
-    index_type nnext = _nexts[next];
-    _nexts[it._pos] = nnext;
+    index_type next = link (it._pos);
+    index_type nnext = link (next);
+    link (it._pos) = nnext;
     return_slot (next);
     return iterator (this, nnext);
   }
@@ -350,11 +728,314 @@ public:
   iterator
   erase_after (const_iterator first, const_iterator last)
   {
-    while (_nexts[first._pos] != last._pos)
+    while (link (first._pos) != last._pos)
       erase_after (first);
     return iterator (this, last._pos);
   }
 
+  // The following operations have the semantics of their
+  // std::forward_list namesakes.  Within one list they only relink,
+  // payloads stay where they are.  Elements that come from another
+  // slist have to be moved to slots of this one, which throws
+  // std::bad_alloc when this list runs out of them.
+
+  // Move all elements of OTHER after IT.
+  void
+  splice_after (const_iterator it, slist &other)
+  {
+    assert (&other != this);
+    index_type p = it._pos;
+    while (!other.empty ())
+      {
+	index_type i = adopt (other, other._head);
+	link (i) = link (p);
+	link (p) = i;
+	p = i;
+	other.pop_front ();
+      }
+  }
+
+  // Move the element after FROM in OTHER after IT.
+  void
+  splice_after (const_iterator it, slist &other, const_iterator from)
+  {
+    index_type n = other.link (from._pos);
+    if (&other == this)
+      {
+	if (n == N || it._pos == from._pos || it._pos == n)
+	  return;
+	link (from._pos) = link (n);
+      }
+    else
+      {
+	n = adopt (other, n);
+	other.erase_after (from);
+      }
+    link (n) = link (it._pos);
+    link (it._pos) = n;
+  }
+
+  // Move the elements strictly between FIRST and LAST in OTHER after
+  // IT.
+  void
+  splice_after (const_iterator it, slist &other,
+		const_iterator first, const_iterator last)
+  {
+    if (&other == this)
+      {
+	index_type b = link (first._pos);
+	if (b == last._pos)
+	  return;
+	index_type e = b;
+	while (link (e) != last._pos)
+	  e = link (e);
+	link (first._pos) = last._pos;
+	link (e) = link (it._pos);
+	link (it._pos) = b;
+	return;
+      }
+
+    index_type p = it._pos;
+    while (other.link (first._pos) != last._pos)
+      {
+	index_type i = adopt (other, other.link (first._pos));
+	link (i) = link (p);
+	link (p) = i;
+	p = i;
+	other.erase_after (first);
+      }
+  }
+
+  // Merge sorted OTHER into this sorted list.  OTHER ends up empty.
+  // Of equal elements, those of this list come first.  Each element
+  // is linked into its place as soon as it's adopted, so when this
+  // list runs out of slots, the elements merged so far stay here and
+  // the rest stay in OTHER.
+  template <class Compare>
+  void
+  merge (slist &other, Compare comp)
+  {
+    if (&other == this)
+      return;
+    index_type prev = N, cur = _head;
+    while (!other.empty ())
+      {
+	while (cur != N && !comp (other.payload (other._head), payload (cur)))
+	  {
+	    prev = cur;
+	    cur = link (cur);
+	  }
+	index_type i = adopt (other, other._head);
+	link (i) = cur;
+	if (prev == N)
+	  _head = i;
+	else
+	  link (prev) = i;
+	prev = i;
+	other.pop_front ();
+      }
+  }
+
+  void
+  merge (slist &other)
+  {
+    merge (other, std::less<T> ());
+  }
+
+  // Stable bottom-up merge sort.  BINS[K] holds a sorted chain of 2^K
+  // elements, or is empty, like the bits of a binary counter.
+  template <class Compare>
+  void
+  sort (Compare comp)
+  {
+    index_type bins[sizeof (size_t) * 8];
+    size_t used = 0;
+    while (_head != N)
+      {
+	index_type chain = _head;
+	_head = link (chain);
+	link (chain) = N;
+
+	size_t k = 0;
+	for (; k < used && bins[k] != N; ++k)
+	  {
+	    chain = merge_chains (bins[k], chain, comp);
+	    bins[k] = N;
+	  }
+	if (k == used)
+	  ++used;
+	bins[k] = chain;
+      }
+
+    // Higher bins hold earlier elements.
+    index_type chain = N;
+    for (size_t k = 0; k < used; ++k)
+      if (bins[k] != N)
+	chain = merge_chains (bins[k], chain, comp);
+    _head = chain;
+  }
+
+  void
+  sort ()
+  {
+    sort (std::less<T> ());
+  }
+
+  void
+  reverse ()
+  {
+    index_type prev = N;
+    for (index_type i = _head; i != N; )
+      {
+	index_type next = link (i);
+	link (i) = prev;
+	prev = i;
+	i = next;
+      }
+    _head = prev;
+  }
+
+  // Move elements to the slots that match their position in the list,
+  // so that iteration walks memory sequentially.  This is MacLaren's
+  // algorithm: the k-th element is swapped into slot k, and slot k's
+  // link temporarily forwards to where the displaced element went.
+  // Free slots are told apart by linking them to themselves, which no
+  // element does, and are then linked in ascending order, and those
+  // past the last element are returned to the never used tail.  This
+  // invalidates iterators.  Answer the number of moved elements.
+  //
+  // BUDGET limits the number of moves, not the work.  Nothing is kept
+  // between calls, so each call walks the whole list and all used
+  // slots however little it moves.  Elements already in place only
+  // cost a step of the walk, so repeated calls do get there, but
+  // compacting a big list in small steps costs a walk per step.
+  size_type
+  compact (size_type budget = N)
+  {
+    for (index_type i = _free; i != N; )
+      {
+	index_type next = link (i);
+	link (i) = i;
+	i = next;
+      }
+
+    size_type k = 0, moved = 0;
+    index_type cur = _head;
+    for (;;)
+      {
+	while (cur < k)
+	  cur = link (cur);
+	if (cur == N)
+	  break;
+
+	index_type next = link (cur);
+	if (cur != k)
+	  {
+	    if (moved == budget)
+	      break;
+	    if (link (k) != k)
+	      {
+		using std::swap;
+		swap (payload (k), payload (cur));
+		link (cur) = link (k);
+	      }
+	    else
+	      {
+		new (bytes (k)) T (std::move (payload (cur)));
+		payload (cur).~T ();
+		link (cur) = cur;
+	      }
+	    link (k) = cur;
+	    ++moved;
+	  }
+	cur = next;
+	++k;
+      }
+
+    // Unplaced elements may still link to forwarding slots.
+    for (index_type i = cur; i != N; i = link (i))
+      while (link (i) < k)
+	link (i) = link (link (i));
+
+    if (k > 0)
+      {
+	for (size_type i = 0; i + 1 < k; ++i)
+	  link (i) = i + 1;
+	link (k - 1) = cur;
+	_head = 0;
+      }
+
+    while (_bump > 0 && link (_bump - 1) == _bump - 1)
+      --_bump;
+    _free = N;
+    for (size_type i = _bump; i-- > 0; )
+      if (link (i) == i)
+	{
+	  link (i) = _free;
+	  _free = i;
+	}
+    return moved;
+  }
+
+  // Answer the fraction of links that lead to the next slot in
+  // memory.  That's 1 after a complete compact.
+  double
+  locality () const
+  {
+    size_type links = 0, sequential = 0;
+    for (index_type i = _head; i != N && link (i) != N; i = link (i))
+      {
+	++links;
+	if (link (i) == i + 1)
+	  ++sequential;
+      }
+    return links == 0 ? 1.0 : double (sequential) / links;
+  }
+
+private:
+  // Move the payload of OTHER's slot I to a new slot of this list
+  // and answer its index.  The caller unlinks I from OTHER.
+  index_type
+  adopt (slist &other, index_type i)
+  {
+    return take_slot (std::move (other.payload (i)));
+  }
+
+  // Merge two sorted chains and answer the head of the result.
+  template <class Compare>
+  index_type
+  merge_chains (index_type a, index_type b, Compare &comp)
+  {
+    index_type head = N, tail = N;
+    while (a != N && b != N)
+      {
+	index_type i;
+	if (comp (payload (b), payload (a)))
+	  {
+	    i = b;
+	    b = link (b);
+	  }
+	else
+	  {
+	    i = a;
+	    a = link (a);
+	  }
+	if (tail == N)
+	  head = i;
+	else
+	  link (tail) = i;
+	tail = i;
+      }
+
+    index_type rest = a != N ? a : b;
+    if (tail == N)
+      return rest;
+    link (tail) = rest;
+    return head;
+  }
+
+public:
+
   reference
   front ()
   {
@@ -435,8 +1116,8 @@ public:
 
 namespace std
 {
-  template <class T, size_t N>
-  struct tuple_size<slist<T, N>>
+  template <class T, size_t N, class Layout>
+  struct tuple_size<slist<T, N, Layout>>
   {
     enum { value = N };
   };
@@ -0,0 +1,183 @@
+/*
+ * Test suite for singly linked lists sharing one slot pool.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "slist_pool.hh"
+#include "hashers.hh"
+#include "huge_pages.hh"
+
+#include <cassert>
+#include <forward_list>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+template <class Pool, class L>
+bool
+same (Pool const &pool, typename Pool::list const &h, L const &l)
+{
+  return std::distance (pool.begin (h), pool.end ())
+    == std::distance (l.begin (), l.end ())
+    && std::equal (pool.begin (h), pool.end (), l.begin ());
+}
+
+// Do random operations on LISTS lists of one pool, and the same on
+// std::forward_lists.
+template <class Layout, size_t N>
+void
+tests (size_t lists)
+{
+  typedef slist_pool<std::string, N, Layout> Pool;
+  std::cout << std::endl << " + " << typeid (Layout).name ()
+	    << " N=" << N << " lists=" << lists << " " << std::flush;
+
+  huge_ptr<Pool> pool = make_huge<Pool> ();
+  std::vector<typename Pool::list> h (lists);
+  std::vector<std::forward_list<std::string>> l (lists);
+  size_t size = 0;
+
+  for (uint64_t r = 0; r < 20 * N; ++r)
+    {
+      uint64_t m = mix64 (r);
+      size_t i = m % lists;
+      size_t j = (m >> 16) % lists;
+      std::string v = std::to_string (r);
+      switch ((m >> 32) % 8)
+	{
+	case 0:
+	case 1:
+	case 2:
+	  if (size == N)
+	    {
+	      bool thrown = false;
+	      try
+		{
+		  pool->push_front (h[i], v);
+		}
+	      catch (std::bad_alloc const &)
+		{
+		  thrown = true;
+		}
+	      assert (thrown);
+	      break;
+	    }
+	  pool->push_front (h[i], v);
+	  l[i].push_front (v);
+	  ++size;
+	  break;
+
+	case 3:
+	  if (size == N || h[i].empty ())
+	    break;
+	  pool->insert_after (pool->begin (h[i]), v);
+	  l[i].insert_after (l[i].begin (), v);
+	  ++size;
+	  break;
+
+	case 4:
+	case 5:
+	  if (h[i].empty ())
+	    break;
+	  assert (pool->front (h[i]) == l[i].front ());
+	  pool->pop_front (h[i]);
+	  l[i].pop_front ();
+	  --size;
+	  break;
+
+	case 6:
+	  if (h[i].empty () || i == j)
+	    break;
+	  pool->move_front (h[j], h[i]);
+	  l[j].splice_after (l[j].before_begin (), l[i], l[i].before_begin ());
+	  break;
+
+	case 7:
+	  if (h[i].empty () || i == j)
+	    break;
+	  if (std::next (pool->begin (h[i])) != pool->end ())
+	    {
+	      pool->erase_after (pool->begin (h[i]));
+	      l[i].erase_after (l[i].begin ());
+	      --size;
+	    }
+	  pool->splice_after (pool->begin (h[i]), h[j]);
+	  l[i].splice_after (l[i].begin (), l[j]);
+	  break;
+	}
+      assert (pool->size () == size);
+      assert (same (*pool, h[i], l[i]) && same (*pool, h[j], l[j]));
+    }
+
+  std::cout << "0" << std::flush;
+  for (size_t i = 0; i < lists; ++i)
+    assert (same (*pool, h[i], l[i]));
+
+  // Clear half of the lists, the pool destroys the rest.
+  std::cout << "1" << std::flush;
+  for (size_t i = 0; i < lists; i += 2)
+    {
+      size -= std::distance (l[i].begin (), l[i].end ());
+      pool->clear (h[i]);
+      assert (h[i].empty ());
+    }
+  assert (pool->size () == size);
+}
+
+// Elements left in the lists are destroyed with the pool.
+void
+destroy_tests ()
+{
+  std::cout << std::endl << " + destroy " << std::flush;
+  struct D
+  {
+    int *ct;
+    explicit D (int *c) : ct (c) {}
+    D (D const &other) : ct (other.ct) {}
+    ~D () { ++*ct; }
+  };
+
+  int ct = 0;
+  {
+    slist_pool<D, 64> pool;
+    slist_pool<D, 64>::list a, b;
+    for (int i = 0; i < 10; ++i)
+      pool.emplace_front (i % 2 ? a : b, &ct);
+    pool.pop_front (a);
+    assert (ct == 1);
+  }
+  assert (ct == 10);
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::cout << "running slist_pool tests" << std::flush;
+  static_assert (sizeof (slist_pool<int, 65535>::list) == 2,
+		 "a list handle is just the head index");
+  tests<slist_split_layout, 1> (1);
+  tests<slist_split_layout, 16> (4);
+  tests<slist_split_layout, 1024> (100);
+  tests<slist_split_layout, 65536> (1000);
+  tests<slist_node_layout, 1024> (100);
+  tests<slist_block_layout, 1024> (100);
+  destroy_tests ();
+  std::cout << std::endl;
+}
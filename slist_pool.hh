@@ -0,0 +1,407 @@
+/*
+ * Implementation of many singly linked lists sharing one slot pool.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Each slist reserves N slots of its own.  When there are many short
+ * lists, most of those slots stay unused, and memory has to be sized
+ * for every list being full at once.  slist_pool holds N slots and
+ * links, laid out like in slist, and any number of lists allocate
+ * from its free list.  A list is just a handle with the index of its
+ * head, so it takes a few bytes, and all operations go through the
+ * pool.  N then bounds the total number of elements in all lists.
+ *
+ * Since lists of the same pool share the links, moving elements from
+ * one list to another only relinks them.
+ *
+ * The pool doesn't know its lists.  The elements that are left in
+ * lists when the pool is destroyed are destroyed with it, and the
+ * handles must not be used after that.  */
+
+#ifndef _SLIST_POOL_H_
+#define _SLIST_POOL_H_
+
+#include <bitset>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "index_type.hh"
+#include "slist.hh"
+
+template<class T, size_t N, class Layout = slist_split_layout>
+class slist_pool
+  : protected Layout::template storage<T, N,
+				       typename index_type_for<N>::type>
+{
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef value_type &reference;
+  typedef const value_type &const_reference;
+  typedef value_type *pointer;
+  typedef const value_type *const_pointer;
+
+protected:
+  typedef typename index_type_for<N>::type index_type;
+  typedef typename Layout::template storage<T, N, index_type> storage;
+  using storage::bytes;
+  using storage::link;
+
+  // Slots from _bump up have never been used.
+  index_type _free;
+  index_type _bump;
+  size_type _size;
+
+  template<class This, class Pool>
+  class iterator_builder
+    : public std::iterator<std::forward_iterator_tag, T>
+  {
+  protected:
+    Pool _pool;
+    index_type _pos;
+
+    iterator_builder (Pool pool, index_type pos)
+      : _pool (pool)
+      , _pos (pos)
+    {}
+
+  public:
+    bool
+    operator == (This const &other) const
+    {
+      return _pos == other._pos;
+    }
+
+    bool
+    operator != (This const &other) const
+    {
+      return !(*this == other);
+    }
+
+    This &
+    operator ++ ()
+    {
+      assert (_pos != N);
+      _pos = _pool->link (_pos);
+      return *(This *)this;
+    }
+
+    This
+    operator ++ (int)
+    {
+      This copy = *(This *)this;
+      ++*this;
+      return copy;
+    }
+  };
+
+public:
+  class list
+  {
+    friend class slist_pool;
+    index_type _head;
+
+  public:
+    list ()
+      : _head (N)
+    {}
+
+    bool
+    empty () const
+    {
+      return _head == N;
+    }
+  };
+
+  class iterator
+    : public iterator_builder<iterator, slist_pool *>
+  {
+    typedef iterator_builder<iterator, slist_pool *> Super;
+    friend class slist_pool;
+
+    iterator (slist_pool *pool, index_type pos)
+      : Super (pool, pos)
+    {}
+
+  public:
+    iterator ()
+      : Super (NULL, N)
+    {}
+
+    reference
+    operator * () const
+    {
+      return this->_pool->payload (this->_pos);
+    }
+
+    pointer
+    operator -> () const
+    {
+      return &**this;
+    }
+  };
+
+  class const_iterator
+    : public iterator_builder<const_iterator, slist_pool const *>
+  {
+    typedef iterator_builder<const_iterator, slist_pool const *> Super;
+    friend class slist_pool;
+
+    const_iterator (slist_pool const *pool, index_type pos)
+      : Super (pool, pos)
+    {}
+
+  public:
+    const_iterator ()
+      : Super (NULL, N)
+    {}
+
+    const_iterator (iterator const &other)
+      : Super (other._pool, other._pos)
+    {}
+
+    const_reference
+    operator * () const
+    {
+      return this->_pool->payload (this->_pos);
+    }
+
+    const_pointer
+    operator -> () const
+    {
+      return &**this;
+    }
+  };
+
+private:
+  reference
+  payload (index_type i)
+  {
+    return *reinterpret_cast<pointer> (bytes (i));
+  }
+
+  const_reference
+  payload (index_type i) const
+  {
+    return *reinterpret_cast<const_pointer> (bytes (i));
+  }
+
+  template <class... Args>
+  index_type
+  take_slot (Args &&... args)
+  {
+    if (_free == N && _bump == N)
+      throw std::bad_alloc ();
+    index_type i = _free != N ? _free : _bump;
+    new (bytes (i)) T (std::forward<Args> (args)...);
+    if (i == _free)
+      _free = link (i);
+    else
+      ++_bump;
+    ++_size;
+    return i;
+  }
+
+  void
+  return_slot (index_type i)
+  {
+    payload (i).~T ();
+    link (i) = _free;
+    _free = i;
+    --_size;
+  }
+
+public:
+  slist_pool ()
+    : _free (N)
+    , _bump (0)
+    , _size (0)
+  {}
+
+  slist_pool (slist_pool const &) = delete;
+  slist_pool &operator = (slist_pool const &) = delete;
+
+  // Whatever is not on the free list is in some list.
+  ~slist_pool ()
+  {
+    if (std::is_trivially_destructible<T>::value)
+      return;
+    std::bitset<N> free;
+    for (index_type i = _free; i != N; i = link (i))
+      free.set (i);
+    for (size_type i = 0; i < _bump; ++i)
+      if (!free[i])
+	payload (i).~T ();
+  }
+
+  template <class... Args>
+  void
+  emplace_front (list &l, Args &&... args)
+  {
+    index_type i = take_slot (std::forward<Args> (args)...);
+    link (i) = l._head;
+    l._head = i;
+  }
+
+  void
+  push_front (list &l, const T &value)
+  {
+    emplace_front (l, value);
+  }
+
+  void
+  push_front (list &l, T &&value)
+  {
+    emplace_front (l, std::move (value));
+  }
+
+  template <class... Args>
+  iterator
+  emplace_after (const_iterator it, Args &&... args)
+  {
+    assert (it._pos < N);
+    index_type i = take_slot (std::forward<Args> (args)...);
+    link (i) = link (it._pos);
+    link (it._pos) = i;
+    return iterator (this, i);
+  }
+
+  iterator
+  insert_after (const_iterator it, const T &value)
+  {
+    return emplace_after (it, value);
+  }
+
+  iterator
+  insert_after (const_iterator it, T &&value)
+  {
+    return emplace_after (it, std::move (value));
+  }
+
+  void
+  pop_front (list &l)
+  {
+    assert (!l.empty ());
+    index_type i = l._head;
+    l._head = link (i);
+    return_slot (i);
+  }
+
+  iterator
+  erase_after (const_iterator it)
+  {
+    index_type n = link (it._pos);
+    index_type nn = link (n);
+    link (it._pos) = nn;
+    return_slot (n);
+    return iterator (this, nn);
+  }
+
+  void
+  clear (list &l)
+  {
+    while (!l.empty ())
+      pop_front (l);
+  }
+
+  // Move the front element of FROM to the front of TO.
+  void
+  move_front (list &to, list &from)
+  {
+    assert (!from.empty ());
+    index_type i = from._head;
+    from._head = link (i);
+    link (i) = to._head;
+    to._head = i;
+  }
+
+  // Move all elements of FROM after IT.
+  void
+  splice_after (const_iterator it, list &from)
+  {
+    if (from.empty ())
+      return;
+    index_type tail = from._head;
+    while (link (tail) != N)
+      tail = link (tail);
+    link (tail) = link (it._pos);
+    link (it._pos) = from._head;
+    from._head = N;
+  }
+
+  reference
+  front (list const &l)
+  {
+    return payload (l._head);
+  }
+
+  const_reference
+  front (list const &l) const
+  {
+    return payload (l._head);
+  }
+
+  iterator
+  begin (list const &l)
+  {
+    return iterator (this, l._head);
+  }
+
+  const_iterator
+  begin (list const &l) const
+  {
+    return const_iterator (this, l._head);
+  }
+
+  iterator
+  end ()
+  {
+    return iterator (this, N);
+  }
+
+  const_iterator
+  end () const
+  {
+    return const_iterator (this, N);
+  }
+
+  // Answer the number of elements in all lists together.
+  size_type
+  size () const
+  {
+    return _size;
+  }
+
+  bool
+  full () const
+  {
+    return _size == N;
+  }
+
+  size_type
+  max_size () const
+  {
+    return N;
+  }
+};
+
+#endif /* _SLIST_POOL_H_ */
@@ -0,0 +1,160 @@
+/*
+ * Test suite for slot maps with generational handles.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "slot_map.hh"
+#include "hashers.hh"
+
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+typedef std::pair<uint32_t, uint32_t> key;
+
+key
+key_of (slot_map_handle h)
+{
+  return key (h.index, h.generation);
+}
+
+template <class M>
+void
+check (M const &m, std::map<key, std::string> const &expect)
+{
+  assert (m.size () == expect.size ());
+  for (auto it = expect.begin (); it != expect.end (); ++it)
+    {
+      slot_map_handle h = { it->first.first, it->first.second };
+      assert (m.contains (h));
+      assert (*m.find (h) == it->second);
+      assert (m[h] == it->second);
+    }
+
+  // Iteration sees each object once, and knows its handle.
+  size_t n = 0;
+  for (auto it = m.begin (); it != m.end (); ++it, ++n)
+    assert (expect.find (key_of (m.handle_of (it)))->second == *it);
+  assert (n == expect.size ());
+}
+
+// Insert and erase at random, compared with a std::map.  Erased
+// handles are kept around to check that they stay stale.
+template <class M>
+void
+tests (M &m, size_t capacity, size_t rounds)
+{
+  std::cout << std::endl << " + " << typeid (M).name ()
+	    << " capacity=" << capacity << " " << std::flush;
+
+  std::map<key, std::string> expect;
+  std::vector<slot_map_handle> live, stale;
+  for (uint64_t r = 0; r < rounds; ++r)
+    {
+      uint64_t x = mix64 (r);
+      if (x % 5 < 3 && live.size () < capacity)
+	{
+	  std::string v = std::to_string (r);
+	  slot_map_handle h = m.insert (v);
+	  assert (expect.find (key_of (h)) == expect.end ());
+	  expect[key_of (h)] = v;
+	  live.push_back (h);
+	}
+      else if (!live.empty ())
+	{
+	  size_t i = (x >> 8) % live.size ();
+	  slot_map_handle h = live[i];
+	  assert (m.erase (h));
+	  assert (!m.erase (h));
+	  expect.erase (key_of (h));
+	  live[i] = live.back ();
+	  live.pop_back ();
+	  stale.push_back (h);
+	}
+      if (r % 1000 == 0)
+	check (m, expect);
+    }
+
+  std::cout << "0" << std::flush;
+  check (m, expect);
+  for (auto it = stale.begin (); it != stale.end (); ++it)
+    {
+      assert (!m.contains (*it));
+      assert (m.find (*it) == NULL);
+    }
+  slot_map_handle bogus = { uint32_t (capacity + 1000), 1 };
+  assert (!m.contains (bogus));
+
+  std::cout << "1" << std::flush;
+  M copy (m);
+  check (copy, expect);
+  m.clear ();
+  assert (m.empty ());
+  for (auto it = live.begin (); it != live.end (); ++it)
+    assert (!m.contains (*it) && copy.contains (*it));
+
+  // Slots are reused after clear, with new generations.
+  std::cout << "2" << std::flush;
+  expect.clear ();
+  for (size_t i = 0; i < live.size (); ++i)
+    {
+      slot_map_handle h = m.insert ("x");
+      assert (!copy.contains (h));
+      expect[key_of (h)] = "x";
+    }
+  check (m, expect);
+}
+
+template <size_t N>
+void
+fixed_tests (size_t rounds)
+{
+  std::unique_ptr<slot_map<std::string, N>> m (new slot_map<std::string, N> ());
+  tests (*m, N, rounds);
+
+  m->clear ();
+  for (size_t i = 0; i < N; ++i)
+    m->insert ("y");
+  bool thrown = false;
+  try
+    {
+      m->insert ("z");
+    }
+  catch (std::bad_alloc const &)
+    {
+      thrown = true;
+    }
+  assert (thrown);
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::cout << "running slot_map tests" << std::flush;
+  fixed_tests<1> (100);
+  fixed_tests<17> (1000);
+  fixed_tests<256> (100000);
+  fixed_tests<70000> (400000);
+
+  growable_slot_map<std::string> g;
+  tests (g, 100000, 400000);
+  std::cout << std::endl;
+}
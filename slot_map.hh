@@ -0,0 +1,535 @@
+/*
+ * Implementation of slot maps with generational handles.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A slot map stores objects and answers a handle for each: the index
+ * of a slot plus the generation of that slot.  Looking up a handle is
+ * two array accesses and no hashing.  Each insert and erase bumps the
+ * generation of the slot, so it is odd while the slot is in use, and
+ * handles to erased objects are recognized as stale even when the
+ * slot was reused.  Generations are 32-bit and wrap around, so a
+ * handle that outlives four billion reuses of its slot might alias.
+ *
+ * Slots are managed like in slist: the free ones are chained through
+ * the slots themselves, and those that were never used are handed out
+ * from a bump index, so construction is O(1).
+ *
+ * The objects themselves live in a separate dense array, in no
+ * particular order, so iterating is a plain walk over memory.  Erase
+ * moves the last object into the hole, and each dense position
+ * remembers its slot so that the slot can be updated.  Pointers to
+ * objects are thus invalidated by erase, handles are not.
+ *
+ * slot_map<T, N> holds at most N objects and allocates nothing.
+ * growable_slot_map<T> keeps everything in std::vectors.  */
+
+#ifndef _SLOT_MAP_H_
+#define _SLOT_MAP_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "index_type.hh"
+
+struct slot_map_handle
+{
+  uint32_t index;
+  uint32_t generation;
+
+  bool
+  operator == (slot_map_handle const &other) const
+  {
+    return index == other.index && generation == other.generation;
+  }
+
+  bool
+  operator != (slot_map_handle const &other) const
+  {
+    return !(*this == other);
+  }
+};
+
+template<class T, size_t N>
+class slot_map
+{
+  static_assert (N < UINT32_MAX, "handles have 32-bit indices");
+
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+  typedef value_type &reference;
+  typedef const value_type &const_reference;
+  typedef value_type *pointer;
+  typedef const value_type *const_pointer;
+  typedef pointer iterator;
+  typedef const_pointer const_iterator;
+  typedef slot_map_handle handle;
+
+private:
+  typedef typename index_type_for<N>::type index_type;
+
+  struct alignas (T) value_slot
+  {
+    unsigned char bytes[sizeof (T)]; // payload
+  };
+
+  struct entry
+  {
+    // Dense position while in use, next free slot otherwise.
+    index_type pos;
+    uint32_t generation;
+  };
+
+  value_slot _values[N];
+  // Slot of each dense position.
+  index_type _owners[N];
+  // Slots from _bump up have never been used.
+  entry _entries[N];
+  index_type _free;
+  index_type _bump;
+  index_type _size;
+
+  reference
+  value (size_type pos)
+  {
+    return *reinterpret_cast<pointer> (_values[pos].bytes);
+  }
+
+  const_reference
+  value (size_type pos) const
+  {
+    return *reinterpret_cast<const_pointer> (_values[pos].bytes);
+  }
+
+  bool
+  valid (handle h) const
+  {
+    return h.index < _bump
+      && _entries[h.index].generation == h.generation
+      && (h.generation & 1);
+  }
+
+  void
+  copy_from (slot_map const &other)
+  {
+    for (size_type i = 0; i < other._size; ++i)
+      new (_values[i].bytes) T (other.value (i));
+    std::copy (other._owners, other._owners + other._size, _owners);
+    std::copy (other._entries, other._entries + other._bump, _entries);
+    _free = other._free;
+    _bump = other._bump;
+    _size = other._size;
+  }
+
+public:
+  slot_map ()
+    : _free (N)
+    , _bump (0)
+    , _size (0)
+  {}
+
+  slot_map (slot_map const &other)
+  {
+    copy_from (other);
+  }
+
+  ~slot_map ()
+  {
+    clear ();
+  }
+
+  slot_map &
+  operator = (slot_map const &other)
+  {
+    if (this != &other)
+      {
+	clear ();
+	copy_from (other);
+      }
+    return *this;
+  }
+
+  // Throws std::bad_alloc if the map is full.
+  template <class... Args>
+  handle
+  emplace (Args &&... args)
+  {
+    if (_size == N)
+      throw std::bad_alloc ();
+    new (_values[_size].bytes) T (std::forward<Args> (args)...);
+
+    index_type i;
+    if (_free != N)
+      {
+	i = _free;
+	_free = _entries[i].pos;
+      }
+    else
+      {
+	i = _bump++;
+	_entries[i].generation = 0;
+      }
+    entry &e = _entries[i];
+    ++e.generation;
+    e.pos = _size;
+    _owners[_size++] = i;
+    handle h = { i, e.generation };
+    return h;
+  }
+
+  handle
+  insert (T const &value)
+  {
+    return emplace (value);
+  }
+
+  handle
+  insert (T &&value)
+  {
+    return emplace (std::move (value));
+  }
+
+  // Answer false if H was stale.
+  bool
+  erase (handle h)
+  {
+    if (!valid (h))
+      return false;
+    entry &e = _entries[h.index];
+    index_type last = _size - 1;
+    if (e.pos != last)
+      {
+	value (e.pos) = std::move (value (last));
+	_owners[e.pos] = _owners[last];
+	_entries[_owners[e.pos]].pos = e.pos;
+      }
+    value (last).~T ();
+    --_size;
+
+    ++e.generation;
+    e.pos = _free;
+    _free = h.index;
+    return true;
+  }
+
+  // Answer NULL if H is stale.
+  pointer
+  find (handle h)
+  {
+    return valid (h) ? &value (_entries[h.index].pos) : NULL;
+  }
+
+  const_pointer
+  find (handle h) const
+  {
+    return valid (h) ? &value (_entries[h.index].pos) : NULL;
+  }
+
+  bool
+  contains (handle h) const
+  {
+    return valid (h);
+  }
+
+  reference
+  operator [] (handle h)
+  {
+    assert (valid (h));
+    return value (_entries[h.index].pos);
+  }
+
+  const_reference
+  operator [] (handle h) const
+  {
+    assert (valid (h));
+    return value (_entries[h.index].pos);
+  }
+
+  // Answer the handle of the object that IT points to.
+  handle
+  handle_of (const_iterator it) const
+  {
+    index_type i = _owners[it - begin ()];
+    handle h = { i, _entries[i].generation };
+    return h;
+  }
+
+  // All handles become stale.
+  void
+  clear ()
+  {
+    while (_size > 0)
+      {
+	index_type i = _owners[_size - 1];
+	handle h = { i, _entries[i].generation };
+	erase (h);
+      }
+  }
+
+  iterator
+  begin ()
+  {
+    return reinterpret_cast<pointer> (_values);
+  }
+
+  const_iterator
+  begin () const
+  {
+    return reinterpret_cast<const_pointer> (_values);
+  }
+
+  iterator
+  end ()
+  {
+    return begin () + _size;
+  }
+
+  const_iterator
+  end () const
+  {
+    return begin () + _size;
+  }
+
+  size_type
+  size () const
+  {
+    return _size;
+  }
+
+  bool
+  empty () const
+  {
+    return _size == 0;
+  }
+
+  size_type
+  max_size () const
+  {
+    return N;
+  }
+};
+
+template<class T>
+class growable_slot_map
+{
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+  typedef value_type &reference;
+  typedef const value_type &const_reference;
+  typedef value_type *pointer;
+  typedef const value_type *const_pointer;
+  typedef typename std::vector<T>::iterator iterator;
+  typedef typename std::vector<T>::const_iterator const_iterator;
+  typedef slot_map_handle handle;
+
+private:
+  static const uint32_t nil = UINT32_MAX;
+
+  struct entry
+  {
+    // Dense position while in use, next free slot otherwise.
+    uint32_t pos;
+    uint32_t generation;
+  };
+
+  std::vector<T> _values;
+  // Slot of each dense position.
+  std::vector<uint32_t> _owners;
+  std::vector<entry> _entries;
+  uint32_t _free;
+
+  bool
+  valid (handle h) const
+  {
+    return h.index < _entries.size ()
+      && _entries[h.index].generation == h.generation
+      && (h.generation & 1);
+  }
+
+public:
+  growable_slot_map ()
+    : _free (nil)
+  {}
+
+  template <class... Args>
+  handle
+  emplace (Args &&... args)
+  {
+    uint32_t i = _free;
+    if (i == nil && _entries.size () == nil)
+      throw std::bad_alloc ();
+    _values.emplace_back (std::forward<Args> (args)...);
+
+    if (i != nil)
+      _free = _entries[i].pos;
+    else
+      {
+	i = _entries.size ();
+	entry e = { 0, 0 };
+	_entries.push_back (e);
+      }
+    entry &e = _entries[i];
+    ++e.generation;
+    e.pos = _owners.size ();
+    _owners.push_back (i);
+    handle h = { i, e.generation };
+    return h;
+  }
+
+  handle
+  insert (T const &value)
+  {
+    return emplace (value);
+  }
+
+  handle
+  insert (T &&value)
+  {
+    return emplace (std::move (value));
+  }
+
+  // Answer false if H was stale.
+  bool
+  erase (handle h)
+  {
+    if (!valid (h))
+      return false;
+    entry &e = _entries[h.index];
+    uint32_t last = _values.size () - 1;
+    if (e.pos != last)
+      {
+	_values[e.pos] = std::move (_values[last]);
+	_owners[e.pos] = _owners[last];
+	_entries[_owners[e.pos]].pos = e.pos;
+      }
+    _values.pop_back ();
+    _owners.pop_back ();
+
+    ++e.generation;
+    e.pos = _free;
+    _free = h.index;
+    return true;
+  }
+
+  // Answer NULL if H is stale.
+  pointer
+  find (handle h)
+  {
+    return valid (h) ? &_values[_entries[h.index].pos] : NULL;
+  }
+
+  const_pointer
+  find (handle h) const
+  {
+    return valid (h) ? &_values[_entries[h.index].pos] : NULL;
+  }
+
+  bool
+  contains (handle h) const
+  {
+    return valid (h);
+  }
+
+  reference
+  operator [] (handle h)
+  {
+    assert (valid (h));
+    return _values[_entries[h.index].pos];
+  }
+
+  const_reference
+  operator [] (handle h) const
+  {
+    assert (valid (h));
+    return _values[_entries[h.index].pos];
+  }
+
+  // Answer the handle of the object that IT points to.
+  handle
+  handle_of (const_iterator it) const
+  {
+    uint32_t i = _owners[it - _values.begin ()];
+    handle h = { i, _entries[i].generation };
+    return h;
+  }
+
+  // All handles become stale.  The slots are kept for reuse.
+  void
+  clear ()
+  {
+    while (!_values.empty ())
+      {
+	uint32_t i = _owners.back ();
+	handle h = { i, _entries[i].generation };
+	erase (h);
+      }
+  }
+
+  void
+  reserve (size_type n)
+  {
+    _values.reserve (n);
+    _owners.reserve (n);
+    _entries.reserve (n);
+  }
+
+  iterator
+  begin ()
+  {
+    return _values.begin ();
+  }
+
+  const_iterator
+  begin () const
+  {
+    return _values.begin ();
+  }
+
+  iterator
+  end ()
+  {
+    return _values.end ();
+  }
+
+  const_iterator
+  end () const
+  {
+    return _values.end ();
+  }
+
+  size_type
+  size () const
+  {
+    return _values.size ();
+  }
+
+  bool
+  empty () const
+  {
+    return _values.empty ();
+  }
+};
+
+#endif /* _SLOT_MAP_H_ */
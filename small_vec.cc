@@ -0,0 +1,312 @@
+/*
+ * Test suite for vector with inline capacity.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "small_vec.hh"
+#include "forward_vec.hh"
+#include "hashers.hh"
+
+#include <cassert>
+#include <forward_list>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Counts live objects, and throws from the copy constructor when
+// told to.
+struct L
+{
+  static int live;
+  static int copies_left;
+  int v;
+
+  L (int vv) : v (vv) { ++live; }
+  L (L &&other) : v (other.v) { ++live; }
+  L (L const &other)
+    : v (other.v)
+  {
+    if (copies_left >= 0 && copies_left-- == 0)
+      throw std::runtime_error ("copy");
+    ++live;
+  }
+  ~L () { --live; }
+  L &operator = (L const &other) { v = other.v; return *this; }
+  bool operator == (L const &other) const { return v == other.v; }
+};
+
+int L::live = 0;
+int L::copies_left = -1;
+
+template <class V, class W>
+bool
+same (V const &v, W const &w)
+{
+  return v.size () == w.size ()
+    && std::equal (v.begin (), v.end (), w.begin ());
+}
+
+// Random edits, compared with std::vector.
+template <class T, size_t N>
+void
+edit_tests (std::vector<T> const &vals)
+{
+  std::cout << std::endl << " + edits " << typeid (T).name ()
+	    << " N=" << N << " " << std::flush;
+  small_vec<T, N> v;
+  std::vector<T> w;
+  size_t n = vals.size ();
+  for (size_t r = 0; r < 20 * n; ++r)
+    {
+      uint64_t m = mix64 (r);
+      T const &x = vals[r % n];
+      size_t at = w.empty () ? 0 : (m >> 8) % (w.size () + 1);
+      // Grow in the first half and shrink in the second.
+      bool grow = (m >> 32) % (20 * n) >= r;
+      switch ((m >> 4) % 4)
+	{
+	case 0:
+	  if (grow)
+	    {
+	      v.push_back (x);
+	      w.push_back (x);
+	    }
+	  else if (!w.empty ())
+	    {
+	      v.pop_back ();
+	      w.pop_back ();
+	    }
+	  break;
+	case 1:
+	  if (grow)
+	    {
+	      assert (*v.insert (v.begin () + at, x) == x);
+	      w.insert (w.begin () + at, x);
+	    }
+	  else if (at < w.size ())
+	    {
+	      v.erase (v.begin () + at);
+	      w.erase (w.begin () + at);
+	    }
+	  break;
+	case 2:
+	  if (grow)
+	    {
+	      size_t k = m % 5;
+	      v.insert (v.begin () + at, k, x);
+	      w.insert (w.begin () + at, k, x);
+	    }
+	  else
+	    {
+	      size_t k = std::min (w.size () - at, size_t (m % 5));
+	      v.erase (v.begin () + at, v.begin () + at + k);
+	      w.erase (w.begin () + at, w.begin () + at + k);
+	    }
+	  break;
+	case 3:
+	  if (grow)
+	    {
+	      size_t k = std::min (n, size_t (m % 7));
+	      v.insert (v.begin () + at, vals.begin (), vals.begin () + k);
+	      w.insert (w.begin () + at, vals.begin (), vals.begin () + k);
+	    }
+	  else if (!w.empty ())
+	    {
+	      // An element of the vector itself.
+	      v.insert (v.begin () + at, v.front ());
+	      w.insert (w.begin () + at, w.front ());
+	    }
+	  break;
+	}
+      assert (v.spilled () == (v.capacity () > N));
+      if (r % 16 == 0)
+	assert (same (v, w));
+    }
+  assert (same (v, w));
+
+  std::cout << "0" << std::flush;
+  small_vec<T, N> v2 (v);
+  assert (v2 == v);
+  v2.resize (w.size () / 2);
+  assert (std::equal (v2.begin (), v2.end (), w.begin ()));
+  v2.resize (w.size () + 3, vals[0]);
+  assert (v2.back () == vals[0]);
+  v2 = v;
+  assert (v2 == v);
+
+  std::cout << "1" << std::flush;
+  // A full vector still keeps its elements in place.
+  small_vec<T, N> v4;
+  for (size_t i = 0; i < N; ++i)
+    v4.emplace_back (vals[i % n]);
+  small_vec<T, N> v3 (std::move (v4));
+  assert (v4.empty () && v3.size () == N);
+  assert (!v3.spilled ());
+  v4.swap (v3);
+  assert (v4.size () == N && v3.empty ());
+
+  v2.emplace_back (vals[0]);
+  T const *data = v2.data ();
+  bool spilled = v2.spilled ();
+  v3 = std::move (v2);
+  assert (v2.empty ());
+  assert (!v2.spilled ());
+  // A heap buffer is passed over, not copied.
+  assert ((v3.data () == data) == spilled);
+  std::cout << std::endl;
+}
+
+template <size_t N>
+void
+tests (size_t n)
+{
+  std::vector<int> ints;
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < n; ++i)
+    {
+      ints.push_back (i);
+      strings.push_back (std::to_string (i) + std::string (i % 40, 'x'));
+    }
+  edit_tests<int, N> (ints);
+  edit_tests<std::string, N> (strings);
+}
+
+// Objects are destroyed exactly once, also when a copy throws in the
+// middle of an insert.
+void
+lifetime_tests ()
+{
+  std::cout << std::endl << " + lifetime " << std::flush;
+  {
+    small_vec<L, 4> v;
+    for (int i = 0; i < 3; ++i)
+      v.emplace_back (i);
+    std::vector<L> more;
+    for (int i = 0; i < 10; ++i)
+      more.emplace_back (100 + i);
+
+    L::copies_left = 5;
+    bool thrown = false;
+    try
+      {
+	v.insert (v.begin () + 1, more.begin (), more.end ());
+      }
+    catch (std::runtime_error const &)
+      {
+	thrown = true;
+      }
+    L::copies_left = -1;
+    assert (thrown);
+    assert (v.size () == 3);
+    for (int i = 0; i < 3; ++i)
+      assert (v[i].v == i);
+
+    L::copies_left = 2;
+    thrown = false;
+    try
+      {
+	v.insert (v.end (), size_t (4), L (7));
+      }
+    catch (std::runtime_error const &)
+      {
+	thrown = true;
+      }
+    L::copies_left = -1;
+    assert (thrown && v.size () == 3);
+    assert (L::live == 13);
+
+    small_vec<L, 4> v2 (more.begin (), more.end ());
+    v2.swap (v);
+    assert (v.size () == 10 && v2.size () == 3);
+
+    // A constructor that throws after spilling gives the buffer back.
+    L::copies_left = 5;
+    thrown = false;
+    try
+      {
+	small_vec<L, 4> v3 (more.begin (), more.end ());
+      }
+    catch (std::runtime_error const &)
+      {
+	thrown = true;
+      }
+    L::copies_left = -1;
+    assert (thrown);
+    assert (L::live == 23);
+  }
+  assert (L::live == 0);
+
+  // Input iterators go in through an append and a rotation.
+  std::istringstream is ("3 4 5 6 7");
+  small_vec<int, 2> v (size_t (2), 1);
+  v.insert (v.begin () + 1, std::istream_iterator<int> (is),
+	    std::istream_iterator<int> ());
+  int expect[] = { 1, 3, 4, 5, 6, 7, 1 };
+  assert (v.size () == 7 && std::equal (v.begin (), v.end (), expect));
+  std::cout << std::endl;
+}
+
+// forward_vec on small_vec behaves like forward_vec on std::vector.
+void
+forward_vec_tests ()
+{
+  std::cout << " + forward_vec on small_vec " << std::flush;
+  typedef forward_vec<int, std::allocator<int>, small_vec<int, 8>> H;
+  std::vector<int> vals;
+  for (int i = 0; i < 100; ++i)
+    vals.push_back (i);
+  H h (vals.begin (), vals.end ());
+  std::forward_list<int> l (vals.begin (), vals.end ());
+  assert (same (std::vector<int> (h.begin (), h.end ()),
+		std::vector<int> (l.begin (), l.end ())));
+
+  auto hi = h.begin ();
+  auto li = l.begin ();
+  std::advance (hi, 10);
+  std::advance (li, 10);
+  hi = h.insert_after (hi, -1);
+  li = l.insert_after (li, -1);
+  h.erase_after (hi);
+  l.erase_after (li);
+  h.resize (5);
+  l.resize (5);
+  h.push_front (-2);
+  l.push_front (-2);
+  assert (same (std::vector<int> (h.begin (), h.end ()),
+		std::vector<int> (l.begin (), l.end ())));
+
+  H h2;
+  h2.swap (h);
+  assert (h.empty () && h2.front () == -2);
+  std::cout << std::endl;
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::cout << "running small_vec tests" << std::flush;
+  tests<1> (10);
+  tests<4> (100);
+  tests<16> (1000);
+  tests<16> (10);
+  tests<100> (2000);
+  lifetime_tests ();
+  forward_vec_tests ();
+}
@@ -0,0 +1,576 @@
+/*
+ * Implementation of vector with inline capacity.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A contiguous sequence with the interface of std::vector, that keeps
+ * up to N elements in place, like slist does, and moves them to the
+ * heap when there are more.  Once on the heap, the elements stay
+ * there until the vector is moved from or destroyed; clear doesn't
+ * give the buffer back.
+ *
+ * Moving a vector whose elements are on the heap only passes the
+ * buffer over.  Moving one whose elements are in place moves them one
+ * by one, so neither move nor swap is O(1), and both invalidate
+ * iterators.
+ *
+ * Elements are shuffled around by move construction, which is
+ * expected not to throw.  */
+
+#ifndef _SMALL_VEC_H_
+#define _SMALL_VEC_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <class T, size_t N>
+class small_vec
+{
+  static_assert (N > 0, "N has to be at least one");
+
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef value_type &reference;
+  typedef const value_type &const_reference;
+  typedef value_type *pointer;
+  typedef const value_type *const_pointer;
+  typedef pointer iterator;
+  typedef const_pointer const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+private:
+  struct alignas (T) slot
+  {
+    unsigned char bytes[sizeof (T)]; // payload
+  };
+
+  pointer _begin;
+  size_type _size;
+  size_type _capacity;
+  slot _inline[N];
+
+  pointer
+  inline_begin ()
+  {
+    return reinterpret_cast<pointer> (_inline);
+  }
+
+  void
+  init ()
+  {
+    _begin = inline_begin ();
+    _size = 0;
+    _capacity = N;
+  }
+
+  static void
+  destroy (pointer first, pointer last)
+  {
+    if (!std::is_trivially_destructible<T>::value)
+      for (; first != last; ++first)
+	first->~T ();
+  }
+
+  // Move N elements from FROM to the free slots at TO.  The ranges
+  // may overlap.
+  static void
+  relocate (pointer from, size_type n, pointer to)
+  {
+    if (to == from)
+      return;
+    if (to > from)
+      for (size_type k = n; k-- > 0; )
+	{
+	  new (to + k) T (std::move (from[k]));
+	  from[k].~T ();
+	}
+    else
+      for (size_type k = 0; k < n; ++k)
+	{
+	  new (to + k) T (std::move (from[k]));
+	  from[k].~T ();
+	}
+  }
+
+  void
+  release ()
+  {
+    if (spilled ())
+      ::operator delete (_begin);
+  }
+
+  void
+  reallocate (size_type capacity)
+  {
+    pointer p = static_cast<pointer> (::operator new (capacity * sizeof (T)));
+    relocate (_begin, _size, p);
+    release ();
+    _begin = p;
+    _capacity = capacity;
+  }
+
+  // Make room for COUNT more elements.
+  void
+  grow (size_type count)
+  {
+    if (_size + count > _capacity)
+      reallocate (std::max (2 * _capacity, _size + count));
+  }
+
+  // Open a hole of COUNT free slots at position I, and answer it.
+  pointer
+  open (size_type i, size_type count)
+  {
+    grow (count);
+    pointer p = _begin + i;
+    relocate (p, _size - i, p + count);
+    return p;
+  }
+
+  // Construct the elements of the hole at P that open (I, COUNT) made
+  // by calling MAKE on each slot.  If that throws, close the hole.
+  template <class Make>
+  void
+  fill (pointer p, size_type i, size_type count, Make make)
+  {
+    size_type k = 0;
+    try
+      {
+	for (; k < count; ++k)
+	  make (p + k);
+      }
+    catch (...)
+      {
+	destroy (p, p + k);
+	relocate (p + count, _size - i, p);
+	throw;
+      }
+    _size += count;
+  }
+
+  template <class ForwardIterator>
+  void
+  insert_range (size_type i, ForwardIterator first, ForwardIterator last,
+		std::forward_iterator_tag)
+  {
+    size_type count = std::distance (first, last);
+    pointer p = open (i, count);
+    fill (p, i, count, [&first] (pointer q) { new (q) T (*first++); });
+  }
+
+  // The count is not known up front, so append the elements and
+  // rotate them in place.
+  template <class InputIterator>
+  void
+  insert_range (size_type i, InputIterator first, InputIterator last,
+		std::input_iterator_tag)
+  {
+    size_type n = _size;
+    try
+      {
+	for (; first != last; ++first)
+	  emplace_back (*first);
+      }
+    catch (...)
+      {
+	erase (begin () + n, end ());
+	throw;
+      }
+    std::rotate (begin () + i, begin () + n, end ());
+  }
+
+  // Take over the elements of OTHER, which is left empty.  This
+  // vector has to be empty and in place.
+  void
+  take (small_vec &other)
+  {
+    if (other.spilled ())
+      {
+	_begin = other._begin;
+	_capacity = other._capacity;
+	_size = other._size;
+	other.init ();
+      }
+    else
+      {
+	relocate (other._begin, other._size, _begin);
+	_size = other._size;
+	other._size = 0;
+      }
+  }
+
+public:
+  small_vec ()
+  {
+    init ();
+  }
+
+  // The constructors that insert delegate to the default one, so
+  // that the destructor releases the buffer if an element throws.
+  explicit small_vec (size_type n, T const &value = T ())
+    : small_vec ()
+  {
+    insert (end (), n, value);
+  }
+
+  template <class InputIterator,
+	    class = typename std::enable_if
+		      <!std::is_integral<InputIterator>::value>::type>
+  small_vec (InputIterator first, InputIterator last)
+    : small_vec ()
+  {
+    insert (end (), first, last);
+  }
+
+  small_vec (small_vec const &other)
+    : small_vec ()
+  {
+    insert (end (), other.begin (), other.end ());
+  }
+
+  small_vec (small_vec &&other)
+  {
+    init ();
+    take (other);
+  }
+
+  ~small_vec ()
+  {
+    clear ();
+    release ();
+  }
+
+  // The buffer of this vector is kept.
+  small_vec &
+  operator = (small_vec const &other)
+  {
+    if (this != &other)
+      {
+	clear ();
+	insert (end (), other.begin (), other.end ());
+      }
+    return *this;
+  }
+
+  small_vec &
+  operator = (small_vec &&other)
+  {
+    if (this != &other)
+      {
+	clear ();
+	release ();
+	init ();
+	take (other);
+      }
+    return *this;
+  }
+
+  void
+  swap (small_vec &other)
+  {
+    small_vec tmp (std::move (other));
+    other = std::move (*this);
+    *this = std::move (tmp);
+  }
+
+  // Answer whether the elements live on the heap.
+  bool
+  spilled () const
+  {
+    return _begin != reinterpret_cast<const_pointer> (_inline);
+  }
+
+  void
+  reserve (size_type n)
+  {
+    if (n > _capacity)
+      reallocate (n);
+  }
+
+  // The buffer is kept for reuse.
+  void
+  clear ()
+  {
+    destroy (_begin, _begin + _size);
+    _size = 0;
+  }
+
+  void
+  resize (size_type n, T const &value = T ())
+  {
+    if (n < _size)
+      erase (begin () + n, end ());
+    else
+      insert (end (), n - _size, value);
+  }
+
+  template <class... Args>
+  void
+  emplace_back (Args &&... args)
+  {
+    if (_size < _capacity)
+      new (_begin + _size) T (std::forward<Args> (args)...);
+    else
+      {
+	// ARGS may refer to an element that reallocation moves.
+	T tmp (std::forward<Args> (args)...);
+	grow (1);
+	new (_begin + _size) T (std::move (tmp));
+      }
+    ++_size;
+  }
+
+  void
+  push_back (T const &value)
+  {
+    emplace_back (value);
+  }
+
+  void
+  push_back (T &&value)
+  {
+    emplace_back (std::move (value));
+  }
+
+  void
+  pop_back ()
+  {
+    assert (_size > 0);
+    _begin[--_size].~T ();
+  }
+
+  template <class... Args>
+  iterator
+  emplace (const_iterator pos, Args &&... args)
+  {
+    size_type i = pos - begin ();
+    // ARGS may refer to an element that open moves.
+    T tmp (std::forward<Args> (args)...);
+    pointer p = open (i, 1);
+    new (p) T (std::move (tmp));
+    ++_size;
+    return p;
+  }
+
+  iterator
+  insert (const_iterator pos, T const &value)
+  {
+    return emplace (pos, value);
+  }
+
+  iterator
+  insert (const_iterator pos, T &&value)
+  {
+    return emplace (pos, std::move (value));
+  }
+
+  iterator
+  insert (const_iterator pos, size_type count, T const &value)
+  {
+    size_type i = pos - begin ();
+    T tmp (value);
+    pointer p = open (i, count);
+    fill (p, i, count, [&tmp] (pointer q) { new (q) T (tmp); });
+    return p;
+  }
+
+  template <class InputIterator,
+	    class = typename std::enable_if
+		      <!std::is_integral<InputIterator>::value>::type>
+  iterator
+  insert (const_iterator pos, InputIterator first, InputIterator last)
+  {
+    size_type i = pos - begin ();
+    typedef typename std::iterator_traits<InputIterator>::iterator_category
+      category;
+    insert_range (i, first, last, category ());
+    return begin () + i;
+  }
+
+  iterator
+  erase (const_iterator first, const_iterator last)
+  {
+    pointer p = begin () + (first - begin ());
+    size_type count = last - first;
+    destroy (p, p + count);
+    relocate (p + count, end () - (p + count), p);
+    _size -= count;
+    return p;
+  }
+
+  iterator
+  erase (const_iterator pos)
+  {
+    return erase (pos, pos + 1);
+  }
+
+  reference
+  operator [] (size_type i)
+  {
+    return _begin[i];
+  }
+
+  const_reference
+  operator [] (size_type i) const
+  {
+    return _begin[i];
+  }
+
+  reference
+  front ()
+  {
+    return _begin[0];
+  }
+
+  const_reference
+  front () const
+  {
+    return _begin[0];
+  }
+
+  reference
+  back ()
+  {
+    return _begin[_size - 1];
+  }
+
+  const_reference
+  back () const
+  {
+    return _begin[_size - 1];
+  }
+
+  pointer
+  data ()
+  {
+    return _begin;
+  }
+
+  const_pointer
+  data () const
+  {
+    return _begin;
+  }
+
+  size_type
+  size () const
+  {
+    return _size;
+  }
+
+  size_type
+  capacity () const
+  {
+    return _capacity;
+  }
+
+  bool
+  empty () const
+  {
+    return _size == 0;
+  }
+
+  iterator
+  begin ()
+  {
+    return _begin;
+  }
+
+  const_iterator
+  begin () const
+  {
+    return _begin;
+  }
+
+  const_iterator
+  cbegin () const
+  {
+    return _begin;
+  }
+
+  iterator
+  end ()
+  {
+    return _begin + _size;
+  }
+
+  const_iterator
+  end () const
+  {
+    return _begin + _size;
+  }
+
+  const_iterator
+  cend () const
+  {
+    return _begin + _size;
+  }
+
+  reverse_iterator
+  rbegin ()
+  {
+    return reverse_iterator (end ());
+  }
+
+  const_reverse_iterator
+  rbegin () const
+  {
+    return const_reverse_iterator (end ());
+  }
+
+  reverse_iterator
+  rend ()
+  {
+    return reverse_iterator (begin ());
+  }
+
+  const_reverse_iterator
+  rend () const
+  {
+    return const_reverse_iterator (begin ());
+  }
+
+  bool
+  operator == (small_vec const &other) const
+  {
+    return _size == other._size
+      && std::equal (begin (), end (), other.begin ());
+  }
+
+  bool
+  operator != (small_vec const &other) const
+  {
+    return !(*this == other);
+  }
+};
+
+template <class T, size_t N>
+void
+swap (small_vec<T, N> &v1, small_vec<T, N> &v2)
+{
+  v1.swap (v2);
+}
+
+#endif /* _SMALL_VEC_H_ */
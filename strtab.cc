@@ -0,0 +1,149 @@
+/*
+ * Test suite for hash table with arena-stored string keys.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "strtab.hh"
+#include "tests.hh"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+template <int N, int M = N * 8 / 10>
+void
+tests ()
+{
+  typedef strtab<std::string, N> H;
+  std::cout << std::endl << " + N=" << N << " " << std::flush;
+
+  TestVector<M, std::string> const test;
+  H h;
+  assert (h == h);
+
+  std::cout << "0" << std::flush;
+  size_t bytes = 0;
+  for (auto i = test.begin (); i != test.end (); ++i)
+    {
+      auto p = h.insert (*i, *i);
+      assert (p.second);
+      assert (p.first->first == *i);
+      bytes += i->size ();
+    }
+  assert (h.size () == test.size ());
+  assert (h.arena_size () == bytes);
+
+  // Lookups of a key embedded in a larger buffer.
+  std::cout << "1" << std::flush;
+  for (auto i = test.begin (); i != test.end (); ++i)
+    {
+      std::string buf = "<" + *i + ">";
+      auto it = h.find (buf.data () + 1, i->size ());
+      assert (it != h.end ());
+      assert (it->first == *i);
+      assert (it->second == *i);
+    }
+  assert (h.find (test.extra ()) == h.end ());
+
+  // Existing keys are neither replaced nor stored again.
+  std::cout << "2" << std::flush;
+  for (auto i = test.begin (); i != test.end (); ++i)
+    {
+      auto p = h.insert (*i, "x");
+      assert (!p.second);
+      assert (p.first->second == *i);
+    }
+  assert (h.arena_size () == bytes);
+
+  std::cout << "3" << std::flush;
+  {
+    size_t count = 0;
+    for (auto it = h.cbegin (); it != h.cend (); ++it, ++count)
+      assert (it->first.str () == it->second);
+    assert (count == h.size ());
+  }
+
+  std::cout << "4" << std::flush;
+  {
+    H h2 = h;
+    assert (h2 == h);
+    assert (h2.arena_size () == bytes);
+    // The copy has keys of its own, except that empty keys aren't
+    // stored at all.
+    if (!test.empty () && !test.front ().empty ())
+      assert (h2.find (test.front ())->first.data
+	      != h.find (test.front ())->first.data);
+
+    h2.insert (test.extra (), test.extra ());
+    assert (h2 != h);
+
+    // Swapping keeps the keys in place.
+    char const *key = h2.find (test.extra ())->first.data;
+    swap (h, h2);
+    assert (h.find (test.extra ())->first.data == key);
+    swap (h, h);
+    swap (h, h2);
+    assert (h2.find (test.extra ())->first.data == key);
+  }
+
+  std::cout << "5" << std::flush;
+  h.clear ();
+  assert (h.size () == 0);
+  assert (h.arena_size () == 0);
+  assert (h.begin () == h.end ());
+  for (auto i = test.begin (); i != test.end (); ++i)
+    assert (h.find (*i) == h.end ());
+  for (auto i = test.begin (); i != test.end (); ++i)
+    assert (h.insert (*i, *i).second);
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::cout << "running strtab tests" << std::flush;
+  tests<1, 0> ();
+  tests<3, 2> ();
+  tests<17> ();
+  tests<1021> ();
+  tests<65521> ();
+
+  // Keys longer than a chunk.
+  std::cout << std::endl << " + long keys " << std::flush;
+  {
+    strtab<int, 17> h;
+    std::vector<std::string> keys;
+    for (int i = 0; i < 10; ++i)
+      keys.push_back (std::string (strtab<int, 17>::chunk_size + i, 'a' + i));
+    for (size_t i = 0; i < keys.size (); ++i)
+      assert (h.insert (keys[i], i).second);
+    for (size_t i = 0; i < keys.size (); ++i)
+      assert (h.find (keys[i])->second == int (i));
+  }
+
+  // The empty key, before any key has been stored.
+  std::cout << std::endl << " + empty key " << std::flush;
+  {
+    strtab<int, 17> h;
+    assert (h.insert (std::string (), 7).second);
+    assert (h.find (std::string ())->second == 7);
+    assert (h.insert ("a", 8).second);
+    strtab<int, 17> h2 (h);
+    assert (h2.find (std::string ())->second == 7);
+  }
+  std::cout << std::endl;
+}
@@ -0,0 +1,550 @@
+/*
+ * Implementation of fixed-size hash table with string keys stored in
+ * an arena.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* In hashtab<std::string, T, N>, each key longer than the SSO buffer
+ * is a separate heap block, and each key comparison follows a pointer
+ * to it.  strtab instead copies the key bytes into large chunks of
+ * memory, and keeps a 32-bit tag taken from the key hash in a
+ * separate array.  A probe looks at the tag first, and only compares
+ * the keys when the tags match.  Lookups take the key as a pointer
+ * and a length, so looking up a piece of a larger buffer doesn't
+ * allocate a temporary std::string.
+ *
+ * Chunks are never moved or freed before the table is cleared, so
+ * pointers to the stored keys stay valid until then.  There's no
+ * removal: the key bytes could only be reclaimed by a rebuild.  */
+
+#ifndef _STRTAB_H_
+#define _STRTAB_H_
+
+#include "hash.hh"
+#include "hashers.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A key stored in strtab's arena.
+struct str_key
+{
+  char const *data;
+  size_t size;
+
+  std::string
+  str () const
+  {
+    return std::string (data, size);
+  }
+
+  bool
+  equals (char const *d, size_t len) const
+  {
+    return size == len && std::memcmp (data, d, len) == 0;
+  }
+
+  bool
+  operator == (std::string const &other) const
+  {
+    return equals (other.data (), other.size ());
+  }
+
+  bool
+  operator != (std::string const &other) const
+  {
+    return !(*this == other);
+  }
+};
+
+template <class T, size_t N,
+	  class Hash2 = typename std::conditional<(N > 100),
+						  default_secondary_hash,
+						  trivial_secondary_hash>::type>
+class strtab
+{
+public:
+  typedef str_key key_type;
+  typedef T mapped_type;
+  typedef std::pair<str_key, T> value_type;
+  typedef size_t size_type;
+  typedef value_type &reference;
+  typedef value_type const &const_reference;
+  typedef value_type *pointer;
+  typedef value_type const *const_pointer;
+
+  class iterator;
+  class const_iterator;
+
+  // Keys are copied to chunks of this size.  Longer keys get a chunk
+  // of their own.
+  static const size_type chunk_size = 64 * 1024;
+
+private:
+  struct alignas (value_type) slot
+  {
+    unsigned char bytes[sizeof (value_type)]; // payload
+  };
+
+  // Zero marks an empty slot, the tags of taken slots have the low
+  // bit set.
+  uint32_t _tags[N];
+  slot _table[N];
+  size_type _size;
+
+  std::vector<std::unique_ptr<char[]>> _chunks;
+  char *_free;
+  size_type _avail;
+  size_type _arena_size;
+
+  Hash2 _hash2;
+
+  value_type const &
+  tab (size_type i) const
+  {
+    return *reinterpret_cast<const_pointer> (_table[i].bytes);
+  }
+
+  value_type &
+  tab (size_type i)
+  {
+    return *reinterpret_cast<pointer> (_table[i].bytes);
+  }
+
+  static uint64_t
+  hash (char const *data, size_t len)
+  {
+    return string_hash () (data, len);
+  }
+
+  static uint32_t
+  tag (uint64_t h)
+  {
+    return uint32_t (h >> 32) | 1;
+  }
+
+  // Find the slot where the key is, or else the empty slot where it
+  // should go.  The latter is N if there's no room at all.
+  size_type
+  find_slot (char const *data, size_t len, uint64_t h, bool &found) const
+  {
+    size_type pos = h % N;
+    size_type d = _hash2 (pos);
+    uint32_t t = tag (h);
+    found = false;
+    for (size_type probes = 1; ; pos = (pos + d) % N, ++probes)
+      {
+	if (_tags[pos] == 0)
+	  return pos;
+	if (_tags[pos] == t && tab (pos).first.equals (data, len))
+	  {
+	    found = true;
+	    return pos;
+	  }
+	if (probes == N)
+	  return N;
+      }
+  }
+
+  char const *
+  store (char const *data, size_t len)
+  {
+    // There may be no chunk yet to point into.
+    static char const empty = 0;
+    if (len == 0)
+      return &empty;
+    if (len > _avail)
+      {
+	size_type size = std::max (len, size_type (chunk_size));
+	_chunks.push_back (std::unique_ptr<char[]> (new char[size]));
+	_free = _chunks.back ().get ();
+	_avail = size;
+      }
+    char *ret = _free;
+    std::memcpy (ret, data, len);
+    _free += len;
+    _avail -= len;
+    _arena_size += len;
+    return ret;
+  }
+
+  size_type
+  next_taken (size_type pos) const
+  {
+    while (pos < N && _tags[pos] == 0)
+      ++pos;
+    return pos;
+  }
+
+  template<class This, class Strtab>
+  class iterator_builder
+    : public std::iterator<std::forward_iterator_tag, value_type>
+  {
+  protected:
+    Strtab _parent;
+    size_type _pos;
+
+    iterator_builder (Strtab parent, size_type pos)
+      : _parent (parent)
+      , _pos (pos)
+    {}
+
+  public:
+    bool
+    operator == (This const &other) const
+    {
+      return _pos == other._pos;
+    }
+
+    bool
+    operator != (This const &other) const
+    {
+      return !(*this == other);
+    }
+
+    This &
+    operator ++ ()
+    {
+      if (_pos < N)
+	_pos = _parent->next_taken (_pos + 1);
+      return *(This *)this;
+    }
+
+    This
+    operator ++ (int)
+    {
+      This copy = *(This *)this;
+      ++*this;
+      return copy;
+    }
+  };
+
+public:
+  class iterator
+    : public iterator_builder<iterator, strtab *>
+  {
+    typedef iterator_builder<iterator, strtab *> Super;
+    friend class strtab;
+
+    iterator (strtab *parent, size_type pos)
+      : Super (parent, pos)
+    {}
+
+  public:
+    iterator ()
+      : Super (NULL, 0)
+    {}
+
+    value_type &
+    operator * () const
+    {
+      return this->_parent->tab (this->_pos);
+    }
+
+    value_type *
+    operator -> () const
+    {
+      return &**this;
+    }
+  };
+
+  class const_iterator
+    : public iterator_builder<const_iterator, strtab const *>
+  {
+    typedef iterator_builder<const_iterator, strtab const *> Super;
+    friend class strtab;
+
+    const_iterator (strtab const *parent, size_type pos)
+      : Super (parent, pos)
+    {}
+
+  public:
+    const_iterator ()
+      : Super (NULL, 0)
+    {}
+
+    const_iterator (iterator const &other)
+      : Super (other._parent, other._pos)
+    {}
+
+    value_type const &
+    operator * () const
+    {
+      return this->_parent->tab (this->_pos);
+    }
+
+    value_type const *
+    operator -> () const
+    {
+      return &**this;
+    }
+  };
+
+  strtab (Hash2 const &hash2 = Hash2 ())
+    : _size (0)
+    , _free (NULL)
+    , _avail (0)
+    , _arena_size (0)
+    , _hash2 (hash2)
+  {
+    std::fill (_tags, _tags + N, uint32_t (0));
+  }
+
+  // The copy keeps the layout of COPY, and packs all its keys into
+  // a single chunk.
+  strtab (strtab const &copy)
+    : _size (copy._size)
+    , _free (NULL)
+    , _avail (0)
+    , _arena_size (0)
+    , _hash2 (copy._hash2)
+  {
+    std::memcpy (_tags, copy._tags, sizeof (_tags));
+    if (copy._arena_size > 0)
+      {
+	_chunks.push_back (std::unique_ptr<char[]>
+			   (new char[copy._arena_size]));
+	_free = _chunks.back ().get ();
+	_avail = copy._arena_size;
+      }
+    for (size_type i = 0; i < N; ++i)
+      if (_tags[i] != 0)
+	{
+	  value_type const &v = copy.tab (i);
+	  str_key key = { store (v.first.data, v.first.size), v.first.size };
+	  new (&_table[i]) value_type (key, v.second);
+	}
+  }
+
+  ~strtab ()
+  {
+    if (!std::is_trivially_destructible<T>::value)
+      for (size_type i = 0; i < N; ++i)
+	if (_tags[i] != 0)
+	  tab (i).~value_type ();
+  }
+
+  // Keys stay where they are, so pointers to them remain valid.
+  void
+  swap (strtab &other)
+  {
+    using std::swap;
+    if (this == &other)
+      return;
+    for (size_type i = 0; i < N; ++i)
+      if (_tags[i] != 0 && other._tags[i] != 0)
+	swap (tab (i), other.tab (i));
+      else if (_tags[i] != 0 || other._tags[i] != 0)
+	{
+	  strtab &from = _tags[i] != 0 ? *this : other;
+	  strtab &to = _tags[i] != 0 ? other : *this;
+	  new (&to._table[i]) value_type (std::move (from.tab (i)));
+	  from.tab (i).~value_type ();
+	}
+    swap (_tags, other._tags);
+    swap (_size, other._size);
+    swap (_chunks, other._chunks);
+    swap (_free, other._free);
+    swap (_avail, other._avail);
+    swap (_arena_size, other._arena_size);
+    swap (_hash2, other._hash2);
+  }
+
+  strtab &
+  operator = (strtab other)
+  {
+    swap (other);
+    return *this;
+  }
+
+  bool
+  operator == (strtab const &other) const
+  {
+    if (_size != other._size)
+      return false;
+    for (const_iterator it = begin (); it != end (); ++it)
+      {
+	const_iterator jt = other.find (it->first.data, it->first.size);
+	if (jt == other.end () || !(jt->second == it->second))
+	  return false;
+      }
+    return true;
+  }
+
+  bool
+  operator != (strtab const &other) const
+  {
+    return !(*this == other);
+  }
+
+  std::pair<iterator, bool>
+  insert (char const *data, size_t len, mapped_type const &value)
+  {
+    uint64_t h = hash (data, len);
+    bool found;
+    size_type pos = find_slot (data, len, h, found);
+    if (found)
+      return std::make_pair (iterator (this, pos), false);
+    if (pos == N)
+      return std::make_pair (end (), false);
+
+    str_key key = { store (data, len), len };
+    new (&_table[pos]) value_type (key, value);
+    _tags[pos] = tag (h);
+    ++_size;
+    return std::make_pair (iterator (this, pos), true);
+  }
+
+  std::pair<iterator, bool>
+  insert (std::string const &key, mapped_type const &value)
+  {
+    return insert (key.data (), key.size (), value);
+  }
+
+  std::pair<iterator, bool>
+  insert (std::pair<std::string, T> const &emt)
+  {
+    return insert (emt.first, emt.second);
+  }
+
+  template <class InputIterator>
+  void
+  insert (InputIterator first, InputIterator last)
+  {
+    for (; first != last; ++first)
+      insert (*first);
+  }
+
+  const_iterator
+  find (char const *data, size_t len) const
+  {
+    bool found;
+    size_type pos = find_slot (data, len, hash (data, len), found);
+    return found ? const_iterator (this, pos) : end ();
+  }
+
+  iterator
+  find (char const *data, size_t len)
+  {
+    bool found;
+    size_type pos = find_slot (data, len, hash (data, len), found);
+    return found ? iterator (this, pos) : end ();
+  }
+
+  const_iterator
+  find (std::string const &key) const
+  {
+    return find (key.data (), key.size ());
+  }
+
+  iterator
+  find (std::string const &key)
+  {
+    return find (key.data (), key.size ());
+  }
+
+  size_type
+  size () const
+  {
+    return _size;
+  }
+
+  // Answer the number of key bytes stored.
+  size_type
+  arena_size () const
+  {
+    return _arena_size;
+  }
+
+  // This frees all key storage at once.
+  void
+  clear ()
+  {
+    if (!std::is_trivially_destructible<T>::value)
+      for (size_type i = 0; i < N; ++i)
+	if (_tags[i] != 0)
+	  tab (i).~value_type ();
+    std::fill (_tags, _tags + N, uint32_t (0));
+    _size = 0;
+    _chunks.clear ();
+    _free = NULL;
+    _avail = 0;
+    _arena_size = 0;
+  }
+
+  iterator
+  begin ()
+  {
+    return iterator (this, next_taken (0));
+  }
+
+  const_iterator
+  begin () const
+  {
+    return const_iterator (this, next_taken (0));
+  }
+
+  const_iterator
+  cbegin () const
+  {
+    return begin ();
+  }
+
+  iterator
+  end ()
+  {
+    return iterator (this, N);
+  }
+
+  const_iterator
+  end () const
+  {
+    return const_iterator (this, N);
+  }
+
+  const_iterator
+  cend () const
+  {
+    return end ();
+  }
+};
+
+namespace std
+{
+  template <class T, size_t N, class Hash2>
+  struct tuple_size<strtab<T, N, Hash2>>
+  {
+    enum { value = N };
+  };
+}
+
+template <class T, size_t N, class Hash2>
+void
+swap (strtab<T, N, Hash2> &t1, strtab<T, N, Hash2> &t2)
+{
+  t1.swap (t2);
+}
+
+#endif /* _STRTAB_H_ */
@@ -1,16 +1,35 @@
 #include "hash.hh"
+#include "hashers.hh"
 #include "slist.hh"
+#include "chunked_slist.hh"
 #include "forward_vec.hh"
+#include "gap_list.hh"
+#include "unrolled_list.hh"
+#include "small_vec.hh"
 #include "assoc_vec.hh"
+#include "bloom.hh"
+#include "dense_hash.hh"
+#include "guarded_hash.hh"
+#include "huge_pages.hh"
+#include "strtab.hh"
+#include "hash_join.hh"
+#include "atomic_slist.hh"
+#include "slot_map.hh"
+#include "ring.hh"
 
 #include <boost/progress.hpp>
 #include <cassert>
+#include <chrono>
+#include <deque>
 #include <forward_list>
 #include <iostream>
 #include <map>
 #include <unordered_map>
 #include <vector>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include "tests.hh"
 
 template<template<size_t N> class Hc>
@@ -67,10 +86,874 @@ test_hash ()
 
 template<template<size_t N> class Hc>
 void
-skip_test ()
+test_misses ()
 {
-  typedef typename Hc<0>::type H;
-  std::cout << "Skipping easurements of " << typeid (H).name () << std::endl;
+  enum { N = 65521, M = 52415 };
+  TestVector<M, int> const test;
+
+  // Test vector elements are 17 apart, so none of the shifted keys
+  // is in the table.
+  std::vector<std::pair<int, int> > vals;
+  std::vector<int> misses;
+  for (auto i = test.begin (); i != test.end (); ++i)
+    {
+      vals.push_back (std::make_pair (*i, *i));
+      misses.push_back (*i + 1);
+    }
+
+  typedef typename Hc<N>::type H;
+  std::cout << "Measuring " << typeid (H).name () << std::endl;
+
+  {
+    H h (vals.begin (), vals.end ());
+    std::cout << " + h.find (miss): " << std::flush;
+    boost::progress_timer t;
+    size_t found = 0;
+    for (int i = 0; i < 100; ++i)
+      for (auto it = misses.begin (); it != misses.end (); ++it)
+	if (h.find (*it) != h.end ())
+	  ++found;
+    assert (found == 0);
+  }
+}
+
+// Test vectors contain integers 17 apart, and strings made of
+// printable characters.
+int
+absent_key (int k)
+{
+  return k + 1;
+}
+
+std::string
+absent_key (std::string const &k)
+{
+  return k + '\x7f';
+}
+
+template<class Key, class Hash, size_t N, size_t M>
+void
+test_hasher ()
+{
+  TestVector<M, Key> const test;
+
+  std::vector<std::pair<Key, Key> > vals;
+  std::vector<Key> misses;
+  for (auto i = test.begin (); i != test.end (); ++i)
+    {
+      vals.push_back (std::make_pair (*i, *i));
+      misses.push_back (absent_key (*i));
+    }
+
+  typedef hashtab<Key, Key, N, Hash> H;
+  std::cout << "Measuring " << typeid (Hash).name () << std::endl;
+
+  H *h = new H;
+  {
+    std::cout << " + h.insert (vals.begin (), vals.end ()): " << std::flush;
+    boost::progress_timer t;
+    for (int i = 0; i < 100; ++i)
+      {
+	h->clear ();
+	h->insert (vals.begin (), vals.end ());
+      }
+  }
+
+  {
+    std::cout << " + h.find (hit): " << std::flush;
+    boost::progress_timer t;
+    for (int i = 0; i < 100; ++i)
+      for (auto it = test.begin (); it != test.end (); ++it)
+	assert (h->find (*it) != h->end ());
+  }
+
+  {
+    std::cout << " + h.find (miss): " << std::flush;
+    boost::progress_timer t;
+    for (int i = 0; i < 100; ++i)
+      for (auto it = misses.begin (); it != misses.end (); ++it)
+	assert (h->find (*it) == h->end ());
+  }
+
+  size_t hit_probes = 0, miss_probes = 0, longest = 0;
+  for (auto it = test.begin (); it != test.end (); ++it)
+    {
+      size_t probes = h->probe_count (*it);
+      hit_probes += probes;
+      longest = std::max (longest, probes);
+    }
+  for (auto it = misses.begin (); it != misses.end (); ++it)
+    miss_probes += h->probe_count (*it);
+  std::cout << " + probes per hit: " << double (hit_probes) / M
+	    << ", per miss: " << double (miss_probes) / M
+	    << ", longest hit: " << longest << std::endl;
+  delete h;
+}
+
+// Keys that all land in the same slot under HASH in a table of size
+// N, and therefore share the whole probe sequence.
+template<class Hash>
+std::vector<int>
+colliding_keys (Hash const &hash, size_t n, size_t count)
+{
+  std::vector<int> keys;
+  size_t target = hash (0) % n;
+  for (int k = 0; keys.size () < count; ++k)
+    if (hash (k) % n == target)
+      keys.push_back (k);
+  return keys;
+}
+
+template<class H>
+void
+time_flood (char const *what, H const &proto, std::vector<int> const &keys,
+	    int rounds = 1000)
+{
+  std::cout << " + " << what << " x" << rounds << ": " << std::flush;
+  boost::progress_timer t;
+  for (int i = 0; i < rounds; ++i)
+    {
+      H h (proto);
+      for (auto it = keys.begin (); it != keys.end (); ++it)
+	h.insert (std::make_pair (*it, *it));
+      for (auto it = keys.begin (); it != keys.end (); ++it)
+	assert (h.find (*it) != h.end ());
+    }
+}
+
+void
+test_flood ()
+{
+  enum { N = 8191, M = 6552 };
+  TestVector<M, int> const test;
+  std::vector<int> const benign (test.begin (), test.end ());
+
+  typedef hashtab<int, int, N> H1;
+  std::cout << "Measuring " << typeid (H1).name () << std::endl;
+  time_flood ("benign keys", H1 (), benign);
+  time_flood ("colliding keys", H1 (),
+	      colliding_keys (std::hash<int> (), N, M), 10);
+
+  // The attacker is assumed to know the initial seed.
+  typedef guarded_hashtab<int, int, N> H2;
+  std::cout << "Measuring " << typeid (H2).name () << std::endl;
+  seeded_hash<int> seed (0x5eed);
+  time_flood ("benign keys", H2 (seed), benign);
+  time_flood ("colliding keys", H2 (seed), colliding_keys (seed, N, M));
+}
+
+template<class Ptr>
+void
+time_random_access (char const *what, Ptr const &h,
+		    std::vector<int> const &keys)
+{
+  std::cout << " + " << what << std::endl;
+  {
+    std::cout << "   + h->insert: " << std::flush;
+    boost::progress_timer t;
+    for (auto it = keys.begin (); it != keys.end (); ++it)
+      h->insert (std::make_pair (*it, *it));
+  }
+  {
+    std::cout << "   + h->find: " << std::flush;
+    boost::progress_timer t;
+    for (int i = 0; i < 3; ++i)
+      for (auto it = keys.begin (); it != keys.end (); ++it)
+	assert (h->find (*it) != h->end ());
+  }
+}
+
+void
+test_huge ()
+{
+  // mix_hash spreads the keys, so each access hits a random page.
+  // With 4KB pages that's tens of thousands of pages, way more than
+  // the TLB can cover.
+  enum { N = 16777213, M = N * 8 / 10 };
+  typedef hashtab<int, int, N, mix_hash<int>> H;
+  std::cout << "Measuring " << typeid (H).name ()
+	    << ", " << sizeof (H) / (1024 * 1024) << "MB" << std::endl;
+
+  std::vector<int> keys;
+  for (int i = 0; i < M; ++i)
+    keys.push_back (i * 17 + 728);
+
+  {
+    std::unique_ptr<H> h (new H);
+    time_random_access ("allocated with new", h, keys);
+  }
+  {
+    huge_ptr<H> h = make_huge<H> ();
+    time_random_access ("allocated with make_huge", h, keys);
+  }
+}
+
+// Iterating a table that's 80% full.
+template<template<size_t N> class Hc>
+void
+test_iteration ()
+{
+  enum { N = 65521, M = 52415 };
+  TestVector<M, int> const test;
+
+  typedef typename Hc<N>::type H;
+  std::cout << "Measuring " << typeid (H).name () << std::endl;
+
+  std::unique_ptr<H> h (new H ());
+  for (auto i = test.begin (); i != test.end (); ++i)
+    h->insert (std::make_pair (*i, *i));
+
+  std::cout << " + iterate: " << std::flush;
+  boost::progress_timer t;
+  long sum = 0;
+  for (int i = 0; i < 10000; ++i)
+    for (auto it = h->begin (); it != h->end (); ++it)
+      sum += it->second;
+  assert (sum != 0);
+}
+
+// Build, look up and clear a table of keys too long for SSO.
+template<class H>
+void
+time_strings (char const *what, std::vector<std::string> const &keys)
+{
+  std::cout << "Measuring " << what << std::endl;
+  std::vector<std::pair<std::string, int> > vals;
+  for (size_t j = 0; j < keys.size (); ++j)
+    vals.push_back (std::make_pair (keys[j], int (j)));
+
+  std::unique_ptr<H> h (new H ());
+  boost::progress_timer t;
+  size_t found = 0;
+  for (int i = 0; i < 100; ++i)
+    {
+      h->clear ();
+      for (size_t j = 0; j < keys.size (); ++j)
+	h->insert (vals[j]);
+      for (size_t j = 0; j < keys.size (); ++j)
+	found += h->find (keys[j]) != h->end ();
+    }
+  assert (found == 100 * keys.size ());
+}
+
+void
+test_strtab ()
+{
+  enum { N = 65521, M = 52415 };
+  TestVector<M, std::string> const test;
+  std::vector<std::string> keys;
+  for (auto i = test.begin (); i != test.end (); ++i)
+    keys.push_back ("some/longer/common/prefix/" + *i);
+
+  time_strings<hashtab<std::string, int, N, string_hash>>
+    ("hashtab<std::string, int>", keys);
+  time_strings<strtab<int, N>> ("strtab<int>", keys);
+}
+
+template<class Join>
+void
+time_join (char const *what, size_t nprobe, Join join)
+{
+  std::cout << "Measuring " << what << ": " << std::flush;
+  auto start = std::chrono::steady_clock::now ();
+  size_t matches = join ();
+  std::chrono::duration<double> secs
+    = std::chrono::steady_clock::now () - start;
+  std::cout << matches << " matches, "
+	    << size_t (nprobe / secs.count ()) << " tuples/s" << std::endl;
+}
+
+void
+test_join ()
+{
+  struct rec
+  {
+    int key;
+    int payload;
+  };
+  std::vector<rec> build, probe;
+  for (int i = 0; i < 500000; ++i)
+    build.push_back (rec { int (mix64 (i) >> 40), i });
+  for (int i = 0; i < 5000000; ++i)
+    probe.push_back (rec { int (mix64 (i % 1000000) >> 40), i });
+  auto key = [] (rec const &r) { return r.key; };
+  long sum = 0;
+  auto fn = [&sum] (rec const &b, rec const &p) { sum += b.payload; };
+
+  time_join ("std::unordered_multimap", probe.size (), [&] ()
+	     {
+	       std::unordered_multimap<int, uint32_t> table;
+	       for (size_t i = 0; i < build.size (); ++i)
+		 table.insert (std::make_pair (build[i].key, uint32_t (i)));
+	       size_t matches = 0;
+	       for (size_t i = 0; i < probe.size (); ++i)
+		 {
+		   auto range = table.equal_range (probe[i].key);
+		   for (auto it = range.first; it != range.second; ++it)
+		     {
+		       fn (build[it->second], probe[i]);
+		       ++matches;
+		     }
+		 }
+	       return matches;
+	     });
+  time_join ("hash_join<1048573>", probe.size (), [&] ()
+	     {
+	       return hash_join<1048573, std::vector<rec>, std::vector<rec>,
+				decltype (key), decltype (key),
+				decltype (fn), int, mix_hash<int>>
+		 (build, probe, key, key, fn);
+	     });
+  time_join ("partitioned_hash_join<32749>", probe.size (), [&] ()
+	     {
+	       return partitioned_hash_join<32749, std::vector<rec>,
+					    std::vector<rec>,
+					    decltype (key), decltype (key),
+					    decltype (fn), int, mix_hash<int>>
+		 (build, probe, key, key, fn);
+	     });
+  assert (sum != 0);
+}
+
+// Run FN (thread_number) on NTHREADS threads and report operations
+// per second, each call of FN doing OPS of them.
+template<class Fn>
+void
+time_threads (char const *what, int nthreads, size_t ops, Fn fn)
+{
+  std::cout << "Measuring " << what << " with " << nthreads
+	    << " threads: " << std::flush;
+  auto start = std::chrono::steady_clock::now ();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nthreads; ++t)
+    threads.push_back (std::thread (fn, t));
+  for (auto it = threads.begin (); it != threads.end (); ++it)
+    it->join ();
+  std::chrono::duration<double> secs
+    = std::chrono::steady_clock::now () - start;
+  std::cout << size_t (nthreads * ops / secs.count ()) << " ops/s"
+	    << std::endl;
+}
+
+void
+test_atomic ()
+{
+  enum { N = 32000, rounds = 1000000 };
+  for (int nthreads = 1; nthreads <= 4; nthreads *= 2)
+    {
+      {
+	std::unique_ptr<atomic_slist<int, N>> s (new atomic_slist<int, N> ());
+	time_threads ("atomic_slist push/pop", nthreads, 2 * rounds,
+		      [&s] (int t)
+		      {
+			int v;
+			for (int i = 0; i < rounds; ++i)
+			  {
+			    s->push_front (i);
+			    s->pop_front (v);
+			  }
+		      });
+      }
+      {
+	std::mutex m;
+	std::forward_list<int> l;
+	time_threads ("std::mutex + std::forward_list push/pop", nthreads,
+		      2 * rounds, [&m, &l] (int t)
+		      {
+			for (int i = 0; i < rounds; ++i)
+			  {
+			    {
+			      std::lock_guard<std::mutex> lock (m);
+			      l.push_front (i);
+			    }
+			    std::lock_guard<std::mutex> lock (m);
+			    if (!l.empty ())
+			      l.pop_front ();
+			  }
+		      });
+      }
+    }
+}
+
+template<class H>
+void
+time_sort (std::vector<int> const &vals)
+{
+  std::cout << "Measuring " << typeid (H).name () << std::endl;
+  std::unique_ptr<H> h (new H (vals.begin (), vals.end ()));
+  {
+    std::cout << " + sort/reverse: " << std::flush;
+    boost::progress_timer t;
+    for (int i = 0; i < 100; ++i)
+      {
+	h->sort ();
+	h->reverse ();
+      }
+  }
+  {
+    size_t half = vals.size () / 2;
+    std::unique_ptr<H> h2 (new H (vals.begin (), vals.begin () + half));
+    std::unique_ptr<H> h3 (new H (vals.begin () + half, vals.end ()));
+    h2->sort ();
+    h3->sort ();
+    std::cout << " + copy and merge halves: " << std::flush;
+    boost::progress_timer t;
+    for (int i = 0; i < 100; ++i)
+      {
+	std::unique_ptr<H> a (new H (*h2));
+	std::unique_ptr<H> b (new H (*h3));
+	a->merge (*b);
+      }
+  }
+}
+
+void
+test_sort ()
+{
+  enum { N = 32000 };
+  std::vector<int> vals;
+  for (int i = 0; i < N - 1; ++i)
+    vals.push_back (int (mix64 (i) % 100000));
+  time_sort<slist<int, N>> (vals);
+  time_sort<unrolled_list<int>> (vals);
+  time_sort<std::forward_list<int>> (vals);
+}
+
+template <class H>
+void
+time_sum (H const &h, char const *what)
+{
+  std::cout << " + sum " << what << " (locality " << h.locality ()
+	    << "): " << std::flush;
+  boost::progress_timer t;
+  long sum = 0;
+  for (int i = 0; i < 100; ++i)
+    for (auto it = h.begin (); it != h.end (); ++it)
+      sum += *it;
+  if (sum == 42)
+    std::cout << "";
+}
+
+// Shuffle the order of a list by sorting it on a hash, then compare
+// iteration before and after compact.  Compacting in steps shows the
+// price of walking the whole list on every call.
+void
+test_compact ()
+{
+  enum { N = 1 << 20 };
+  typedef slist<int, N> H;
+  std::cout << "Measuring " << typeid (H).name () << std::endl;
+  std::unique_ptr<H> h (new H ());
+  for (int i = 0; i < N; ++i)
+    h->push_front (i);
+  h->sort ([] (int a, int b) { return mix64 (a) < mix64 (b); });
+  std::unique_ptr<H> h2 (new H (*h));
+  time_sum (*h, "churned");
+  {
+    std::cout << " + compact: " << std::flush;
+    boost::progress_timer t;
+    h->compact ();
+  }
+  time_sum (*h, "compacted");
+  {
+    std::cout << " + compact in steps of 4096, a walk each: " << std::flush;
+    boost::progress_timer t;
+    while (h2->compact (4096) > 0)
+      ;
+  }
+}
+
+struct payload64
+{
+  int key;
+  char pad[60];
+
+  payload64 (int k = 0)
+    : key (k)
+  {}
+};
+
+int
+key_of (int v)
+{
+  return v;
+}
+
+int
+key_of (payload64 const &v)
+{
+  return v.key;
+}
+
+// Walk a list whose order is unrelated to memory order, and one that
+// is in memory order.  Then copy and swap it, which for trivially
+// copyable payloads goes in bulk.
+template <class H>
+void
+time_layout ()
+{
+  enum { N = 1 << 18 };
+  typedef typename H::value_type T;
+  std::cout << "Measuring " << typeid (H).name () << std::endl;
+  huge_ptr<H> h = make_huge<H> ();
+  for (int i = 0; i < N; ++i)
+    h->push_front (T (i));
+  h->sort ([] (T const &a, T const &b)
+	   { return mix64 (key_of (a)) < mix64 (key_of (b)); });
+
+  long sum = 0;
+  {
+    std::cout << " + walk shuffled: " << std::flush;
+    boost::progress_timer t;
+    for (int i = 0; i < 100; ++i)
+      for (auto it = h->begin (); it != h->end (); ++it)
+	sum += key_of (*it);
+  }
+  h->compact ();
+  {
+    std::cout << " + walk in order: " << std::flush;
+    boost::progress_timer t;
+    for (int i = 0; i < 100; ++i)
+      for (auto it = h->begin (); it != h->end (); ++it)
+	sum += key_of (*it);
+  }
+  {
+    std::cout << " + copy and swap: " << std::flush;
+    boost::progress_timer t;
+    huge_ptr<H> h2 = make_huge<H> ();
+    for (int i = 0; i < 100; ++i)
+      {
+	huge_ptr<H> h3 = make_huge<H> (*h);
+	h2->swap (*h3);
+      }
+    sum += key_of (h2->front ());
+  }
+  if (sum == 42)
+    std::cout << "";
+}
+
+void
+test_layout ()
+{
+  enum { N = 1 << 18 };
+  time_layout<slist<int, N, slist_split_layout>> ();
+  time_layout<slist<int, N, slist_node_layout>> ();
+  time_layout<slist<int, N, slist_block_layout>> ();
+  time_layout<slist<payload64, N, slist_split_layout>> ();
+  time_layout<slist<payload64, N, slist_node_layout>> ();
+  time_layout<slist<payload64, N, slist_block_layout>> ();
+}
+
+// Erase a run of K elements from the middle of a list and insert it
+// back, then shrink the list and grow it back.
+template <class H>
+void
+time_bulk (size_t k)
+{
+  enum { N = 100000, rounds = 200 };
+  std::cout << "Measuring " << typeid (H).name () << " K=" << k << std::endl;
+  std::vector<int> vals (N);
+  for (size_t i = 0; i < N; ++i)
+    vals[i] = int (i);
+  H h (vals.begin (), vals.end ());
+  {
+    std::cout << " + erase_after/insert_after range: " << std::flush;
+    boost::progress_timer t;
+    for (int r = 0; r < rounds; ++r)
+      {
+	auto first = h.cbegin ();
+	std::advance (first, N / 2);
+	auto last = first;
+	std::advance (last, k + 1);
+	h.erase_after (first, last);
+	h.insert_after (first, vals.begin (), vals.begin () + k);
+      }
+  }
+  {
+    std::cout << " + resize: " << std::flush;
+    boost::progress_timer t;
+    for (int r = 0; r < rounds; ++r)
+      {
+	h.resize (N - k);
+	h.resize (N);
+      }
+  }
+}
+
+void
+test_bulk ()
+{
+  for (size_t k = 10; k <= 10000; k *= 10)
+    {
+      time_bulk<forward_vec<int>> (k);
+      time_bulk<std::forward_list<int>> (k);
+    }
+}
+
+// Insert after a cursor and erase after it, so that it moves forward
+// through the middle of the list.
+template <class H>
+void
+time_cursor ()
+{
+  enum { N = 100000, rounds = 40000 };
+  std::cout << "Measuring " << typeid (H).name () << std::endl;
+  std::vector<int> vals (N);
+  for (size_t i = 0; i < N; ++i)
+    vals[i] = int (i);
+  H h (vals.begin (), vals.end ());
+  auto it = h.begin ();
+  std::advance (it, N / 10);
+
+  std::cout << " + insert_after/erase_after at cursor: " << std::flush;
+  boost::progress_timer t;
+  for (int r = 0; r < rounds; ++r)
+    {
+      it = h.insert_after (it, r);
+      it = h.erase_after (it);
+    }
+}
+
+void
+test_cursor ()
+{
+  time_cursor<forward_vec<int>> ();
+  time_cursor<gap_list<int>> ();
+  time_cursor<std::forward_list<int>> ();
+}
+
+// Build many short lists and walk each once.
+template <class H>
+void
+time_small (size_t len)
+{
+  enum { rounds = 2000000 };
+  std::cout << "Measuring " << typeid (H).name () << std::endl;
+  std::cout << " + " << rounds << " lists of " << len << ": " << std::flush;
+  boost::progress_timer t;
+  long sum = 0;
+  for (int r = 0; r < rounds; ++r)
+    {
+      H h;
+      for (size_t i = 0; i < len; ++i)
+	h.push_front (r + i);
+      for (auto it = h.begin (); it != h.end (); ++it)
+	sum += *it;
+    }
+  if (sum == 42)
+    std::cout << "";
+}
+
+void
+test_small ()
+{
+  typedef forward_vec<int, std::allocator<int>, small_vec<int, 8>> small_fwdvec;
+  for (size_t len = 4; len <= 16; len *= 2)
+    {
+      time_small<forward_vec<int>> (len);
+      time_small<small_fwdvec> (len);
+      time_small<std::forward_list<int>> (len);
+    }
+}
+
+// The ring interface on top of std::deque and std::mutex.
+template <class T>
+class mutex_deque
+{
+  std::mutex _m;
+  std::deque<T> _q;
+
+public:
+  bool
+  try_push (T const &value)
+  {
+    std::lock_guard<std::mutex> lock (_m);
+    _q.push_back (value);
+    return true;
+  }
+
+  bool
+  try_pop (T &value)
+  {
+    std::lock_guard<std::mutex> lock (_m);
+    if (_q.empty ())
+      return false;
+    value = _q.front ();
+    _q.pop_front ();
+    return true;
+  }
+
+  size_t
+  push_batch (T const *first, size_t count)
+  {
+    std::lock_guard<std::mutex> lock (_m);
+    _q.insert (_q.end (), first, first + count);
+    return count;
+  }
+
+  size_t
+  pop_batch (T *out, size_t count)
+  {
+    std::lock_guard<std::mutex> lock (_m);
+    size_t n = std::min (count, _q.size ());
+    std::copy (_q.begin (), _q.begin () + n, out);
+    _q.erase (_q.begin (), _q.begin () + n);
+    return n;
+  }
+};
+
+// Even threads produce, odd ones consume, BATCH elements at a time.
+template <class Q>
+void
+time_queue (char const *what, Q &q, int pairs, size_t batch)
+{
+  enum { rounds = 1000000 };
+  std::string name = std::string (what) + " batch "
+    + std::to_string (batch);
+  time_threads (name.c_str (), 2 * pairs, rounds, [&q, batch] (int t)
+		{
+		  int buf[64];
+		  for (size_t i = 0; i < rounds; )
+		    {
+		      size_t n = std::min (batch, rounds - i);
+		      if (t % 2 == 0)
+			{
+			  for (size_t j = 0; j < n; ++j)
+			    buf[j] = int (i + j);
+			  n = batch == 1 ? q.try_push (buf[0])
+			    : q.push_batch (buf, n);
+			}
+		      else
+			n = batch == 1 ? q.try_pop (buf[0])
+			  : q.pop_batch (buf, n);
+		      if (n == 0)
+			std::this_thread::yield ();
+		      i += n;
+		    }
+		});
+}
+
+void
+test_ring ()
+{
+  enum { N = 4096 };
+  for (size_t batch = 1; batch <= 64; batch *= 8)
+    {
+      {
+	ring_ptr<int, N, ring_spsc> q (make_ring<int, N, ring_spsc> ());
+	time_queue ("ring spsc", *q, 1, batch);
+      }
+      for (int pairs = 1; pairs <= 2; ++pairs)
+	{
+	  {
+	    ring_ptr<int, N, ring_mpmc> q (make_ring<int, N, ring_mpmc> ());
+	    time_queue ("ring mpmc", *q, pairs, batch);
+	  }
+	  {
+	    mutex_deque<int> q;
+	    time_queue ("std::mutex + std::deque", q, pairs, batch);
+	  }
+	}
+    }
+}
+
+// Look objects up by handle, erase and insert some, and sum all of
+// them, in a slot map and in an unordered_map keyed by id.
+template <class M>
+void
+time_slot_map (M &m, char const *what)
+{
+  enum { N = 100000, rounds = 100 };
+  std::cout << "Measuring " << what << std::endl;
+  std::vector<slot_map_handle> handles;
+  for (int i = 0; i < N; ++i)
+    handles.push_back (m.insert (i));
+
+  long sum = 0;
+  {
+    std::cout << " + lookup: " << std::flush;
+    boost::progress_timer t;
+    for (int r = 0; r < rounds; ++r)
+      for (int i = 0; i < N; ++i)
+	sum += m[handles[mix64 (i) % N]];
+  }
+  {
+    std::cout << " + erase/insert: " << std::flush;
+    boost::progress_timer t;
+    for (int r = 0; r < rounds; ++r)
+      for (int i = 0; i < N; i += 10)
+	{
+	  size_t j = mix64 (r * N + i) % N;
+	  m.erase (handles[j]);
+	  handles[j] = m.insert (i);
+	}
+  }
+  {
+    std::cout << " + iterate: " << std::flush;
+    boost::progress_timer t;
+    for (int r = 0; r < 10 * rounds; ++r)
+      for (auto it = m.begin (); it != m.end (); ++it)
+	sum += *it;
+  }
+  if (sum == 42)
+    std::cout << "";
+}
+
+// The same interface on top of std::unordered_map.
+struct unordered_slot_map
+{
+  std::unordered_map<uint32_t, int> _map;
+  uint32_t _next_id = 0;
+
+  slot_map_handle
+  insert (int v)
+  {
+    slot_map_handle h = { _next_id++, 1 };
+    _map.insert (std::make_pair (h.index, v));
+    return h;
+  }
+
+  void
+  erase (slot_map_handle h)
+  {
+    _map.erase (h.index);
+  }
+
+  int &
+  operator [] (slot_map_handle h)
+  {
+    return _map.find (h.index)->second;
+  }
+
+  struct iterator
+    : std::unordered_map<uint32_t, int>::iterator
+  {
+    iterator (std::unordered_map<uint32_t, int>::iterator it)
+      : std::unordered_map<uint32_t, int>::iterator (it)
+    {}
+
+    int &operator * () const { return (*this)->second; }
+  };
+
+  iterator begin () { return _map.begin (); }
+  iterator end () { return _map.end (); }
+};
+
+void
+test_slot_map ()
+{
+  {
+    std::unique_ptr<slot_map<int, 100000>> m (new slot_map<int, 100000> ());
+    time_slot_map (*m, "slot_map");
+  }
+  {
+    growable_slot_map<int> m;
+    time_slot_map (m, "growable_slot_map");
+  }
+  {
+    unordered_slot_map m;
+    time_slot_map (m, "std::unordered_map");
+  }
 }
 
 template<template <size_t N> class Hc>
@@ -150,6 +1033,18 @@ struct slistC
   typedef slist<int, N> type;
 };
 
+template<size_t N>
+struct chunkedC
+{
+  typedef chunked_slist<int, 1024> type;
+};
+
+template<size_t N>
+struct unrolledC
+{
+  typedef unrolled_list<int> type;
+};
+
 template<size_t N>
 struct fwdlistC
 {
@@ -168,6 +1063,18 @@ struct hashtabC
   typedef hashtab<int, int, N> type;
 };
 
+template<size_t N>
+struct densehashC
+{
+  typedef dense_hashtab<int, int, N> type;
+};
+
+template<size_t N>
+struct bloomC
+{
+  typedef bloom_hashtab<int, int, N> type;
+};
+
 template<size_t N>
 struct mapC
 {
@@ -198,15 +1105,61 @@ main(int argc, char *argv[])
 	  test_hash<hashtabC> ();
 	  test_hash<mapC> ();
 	  test_hash<unomapC> ();
-
-	  // Associative vector is extremely inefficient, just skip
-	  // the test.
-	  skip_test<assocvecC> ();
+	  test_hash<assocvecC> ();
+	}
+      else if (arg == "dense")
+	{
+	  test_hash<hashtabC> ();
+	  test_hash<densehashC> ();
+	  test_iteration<hashtabC> ();
+	  test_iteration<densehashC> ();
+	  test_iteration<unomapC> ();
+	}
+      else if (arg == "sort")
+	test_sort ();
+      else if (arg == "compact")
+	test_compact ();
+      else if (arg == "layout")
+	test_layout ();
+      else if (arg == "slotmap")
+	test_slot_map ();
+      else if (arg == "ring")
+	test_ring ();
+      else if (arg == "bulk")
+	test_bulk ();
+      else if (arg == "cursor")
+	test_cursor ();
+      else if (arg == "small")
+	test_small ();
+      else if (arg == "atomic")
+	test_atomic ();
+      else if (arg == "join")
+	test_join ();
+      else if (arg == "strtab")
+	test_strtab ();
+      else if (arg == "hashers")
+	{
+	  test_hasher<int, std::hash<int>, 65521, 52415> ();
+	  test_hasher<int, mix_hash<int>, 65521, 52415> ();
+	  test_hasher<std::string, std::hash<std::string>, 8191, 6552> ();
+	  test_hasher<std::string, string_hash, 8191, 6552> ();
+	}
+      else if (arg == "flood")
+	test_flood ();
+      else if (arg == "huge")
+	test_huge ();
+      else if (arg == "bloom")
+	{
+	  test_misses<hashtabC> ();
+	  test_misses<bloomC> ();
+	  test_misses<unomapC> ();
 	}
       else if (arg == "slist")
 	{
 	  test_slist<fwdvecC> ();
 	  test_slist<slistC> ();
+	  test_slist<chunkedC> ();
+	  test_slist<unrolledC> ();
 	  test_slist<fwdlistC> ();
 	}
       else
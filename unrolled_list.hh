@@ -0,0 +1,1030 @@
+/*
+ * Implementation of singly linked list interface as an unrolled
+ * linked list.
+ *
+ * Copyright (C) 2012 Petr Machata
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The list is a chain of heap blocks of Bytes bytes each, aligned to
+ * cache lines.  A block holds a link to the next block, a count, and
+ * as many elements as fit in the rest, kept packed at the front of
+ * the block in list order.  Iteration thus chases one pointer per block instead of one
+ * per element, and an edit shifts at most one block's worth of
+ * elements.
+ *
+ * Inserting into a full block splits it in halves, except when the
+ * new element goes to its end, in which case it goes to the front of
+ * the next block if there's room there, or to a new block.  When
+ * erase leaves a block less than half full, the block takes the
+ * elements of the next one if they all fit, or else borrows one of
+ * them.  So blocks are at least half full, except those that are
+ * followed by one that's full.
+ *
+ * splice_after, merge, sort and reverse work on whole blocks where
+ * they can.  Splicing cuts blocks at the ends of the moved range and
+ * relinks the blocks in between, merging moves elements into blocks
+ * as they come but relinks whole blocks that go in one piece.  Where
+ * blocks meet, they are joined if they fit in one, but these
+ * operations may leave blocks less than half full.
+ *
+ * At least two elements go in a block, so for big T the blocks are
+ * bigger than Bytes.  Any edit may move elements between blocks and
+ * thus invalidates iterators, except that erase_after keeps its
+ * argument valid.  */
+
+#ifndef _UNROLLED_LIST_H_
+#define _UNROLLED_LIST_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "index_type.hh"
+
+template<class T, size_t Bytes = 64>
+class unrolled_list
+{
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef value_type &reference;
+  typedef const value_type &const_reference;
+  typedef value_type *pointer;
+  typedef const value_type *const_pointer;
+
+private:
+  typedef typename index_type_for<Bytes>::type count_type;
+
+  // Size of the block header, padded for the alignment of T.
+  static constexpr size_t header_size
+    = (sizeof (void *) + sizeof (count_type) + alignof (T) - 1)
+      / alignof (T) * alignof (T);
+
+public:
+  // Number of elements in one block.
+  static constexpr size_t block_size
+    = Bytes < header_size + 2 * sizeof (T)
+      ? 2 : (Bytes - header_size) / sizeof (T);
+
+private:
+  static_assert (block_size <= Bytes, "count_type is too narrow");
+
+  enum { line_size = 64 };
+
+  struct alignas (T) slot
+  {
+    unsigned char bytes[sizeof (T)]; // payload
+  };
+
+  struct block
+  {
+    block *next;
+    count_type count;
+    slot slots[block_size];
+
+    block ()
+      : next (NULL)
+      , count (0)
+    {}
+
+    reference
+    payload (size_type i)
+    {
+      return *reinterpret_cast<pointer> (slots[i].bytes);
+    }
+
+    const_reference
+    payload (size_type i) const
+    {
+      return *reinterpret_cast<const_pointer> (slots[i].bytes);
+    }
+  };
+
+  block *_head;
+
+  template<class This, class Block>
+  class iterator_builder
+    : public std::iterator<std::forward_iterator_tag, T>
+  {
+  protected:
+    // The end iterator has NULL _block.
+    Block *_block;
+    size_type _pos;
+
+    iterator_builder (Block *b, size_type pos)
+      : _block (b)
+      , _pos (pos)
+    {}
+
+  public:
+    bool
+    operator == (This const &other) const
+    {
+      return _block == other._block && _pos == other._pos;
+    }
+
+    bool
+    operator != (This const &other) const
+    {
+      return !(*this == other);
+    }
+
+    This &
+    operator ++ ()
+    {
+      assert (_block != NULL);
+      if (++_pos == _block->count)
+	{
+	  _block = _block->next;
+	  _pos = 0;
+	}
+      return *(This *)this;
+    }
+
+    This
+    operator ++ (int)
+    {
+      This copy = *(This *)this;
+      ++*this;
+      return copy;
+    }
+  };
+
+public:
+  class iterator
+    : public iterator_builder<iterator, block>
+  {
+    typedef iterator_builder<iterator, block> Super;
+    friend class unrolled_list;
+
+    iterator (block *b, size_type pos)
+      : Super (b, pos)
+    {}
+
+  public:
+    iterator ()
+      : Super (NULL, 0)
+    {}
+
+    reference
+    operator * () const
+    {
+      return this->_block->payload (this->_pos);
+    }
+
+    pointer
+    operator -> () const
+    {
+      return &**this;
+    }
+  };
+
+  class const_iterator
+    : public iterator_builder<const_iterator, block const>
+  {
+    typedef iterator_builder<const_iterator, block const> Super;
+    friend class unrolled_list;
+
+    const_iterator (block const *b, size_type pos)
+      : Super (b, pos)
+    {}
+
+  public:
+    const_iterator ()
+      : Super (NULL, 0)
+    {}
+
+    const_iterator (iterator const &other)
+      : Super (other._block, other._pos)
+    {}
+
+    const_reference
+    operator * () const
+    {
+      return this->_block->payload (this->_pos);
+    }
+
+    const_pointer
+    operator -> () const
+    {
+      return &**this;
+    }
+  };
+
+private:
+  // Answer the iterator at position I of B, which may be one past
+  // the last element of B.
+  static iterator
+  iter (block *b, size_type i)
+  {
+    if (i == b->count)
+      return iterator (b->next, 0);
+    return iterator (b, i);
+  }
+
+  // Move the payload of slot I of FROM to the free slot J of TO.
+  static void
+  relocate (block *from, size_type i, block *to, size_type j)
+  {
+    new (to->slots[j].bytes) T (std::move (from->payload (i)));
+    from->payload (i).~T ();
+  }
+
+  // Move elements FIRST up to LAST of FROM to the free slots from J
+  // on of TO.  The ranges may overlap when FROM is TO.
+  static void
+  relocate (block *from, size_type first, size_type last,
+	    block *to, size_type j)
+  {
+    if (from == to && j > first)
+      for (size_type k = last - first; k-- > 0; )
+	relocate (from, first + k, to, j + k);
+    else
+      for (size_type k = 0; k < last - first; ++k)
+	relocate (from, first + k, to, j + k);
+  }
+
+  // Answer a new empty unlinked block.  Blocks start on a cache line,
+  // which operator new doesn't do before C++17.
+  static block *
+  alloc_block ()
+  {
+    void *p;
+    if (posix_memalign (&p, alignof (block) > line_size
+			? alignof (block) : line_size, sizeof (block)))
+      throw std::bad_alloc ();
+    return new (p) block ();
+  }
+
+  static void
+  free_block (block *b)
+  {
+    b->~block ();
+    std::free (b);
+  }
+
+  // Answer a new unlinked block that holds one new element.
+  template <class... Args>
+  static block *
+  new_block (Args &&... args)
+  {
+    block *b = alloc_block ();
+    try
+      {
+	new (b->slots[0].bytes) T (std::forward<Args> (args)...);
+      }
+    catch (...)
+      {
+	free_block (b);
+	throw;
+      }
+    b->count = 1;
+    return b;
+  }
+
+  // Construct a new element at position J of B, where J may be one
+  // past the last element of B.  Answer where the element ended up.
+  template <class... Args>
+  static iterator
+  insert_at (block *b, size_type j, Args &&... args)
+  {
+    // ARGS may refer to an element that the split or the shift moves.
+    T tmp (std::forward<Args> (args)...);
+    if (b->count == block_size)
+      {
+	if (j == block_size)
+	  {
+	    if (b->next == NULL || b->next->count == block_size)
+	      {
+		block *n = new_block (std::move (tmp));
+		n->next = b->next;
+		b->next = n;
+		return iterator (n, 0);
+	      }
+	    b = b->next;
+	    j = 0;
+	  }
+	else
+	  {
+	    enum { half = block_size / 2 };
+	    block *n = alloc_block ();
+	    n->next = b->next;
+	    b->next = n;
+	    relocate (b, half, block_size, n, 0);
+	    n->count = block_size - half;
+	    b->count = half;
+	    if (j > half)
+	      {
+		b = n;
+		j -= half;
+	      }
+	  }
+      }
+
+    relocate (b, j, b->count, b, j + 1);
+    try
+      {
+	new (b->slots[j].bytes) T (std::move (tmp));
+      }
+    catch (...)
+      {
+	relocate (b, j + 1, b->count + 1, b, j);
+	throw;
+      }
+    ++b->count;
+    return iterator (b, j);
+  }
+
+  // Destroy the element at position J of B, which has other elements
+  // too.  Answer the iterator of the element that followed it.
+  static iterator
+  erase_at (block *b, size_type j)
+  {
+    b->payload (j).~T ();
+    relocate (b, j + 1, b->count, b, j);
+    --b->count;
+
+    block *n = b->next;
+    if (b->count < block_size / 2 && n != NULL)
+      {
+	if (b->count + n->count <= block_size)
+	  {
+	    relocate (n, 0, n->count, b, b->count);
+	    b->count += n->count;
+	    b->next = n->next;
+	    free_block (n);
+	  }
+	else
+	  {
+	    relocate (n, 0, b, b->count++);
+	    relocate (n, 1, n->count, n, 0);
+	    --n->count;
+	  }
+      }
+    return iter (b, j);
+  }
+
+  // Like erase_at (B, 0), but B may hold just that one element, and
+  // is then unlinked from PREV, or from the head if PREV is NULL.
+  iterator
+  erase_front (block *prev, block *b)
+  {
+    if (b->count > 1)
+      return erase_at (b, 0);
+    b->payload (0).~T ();
+    block *n = b->next;
+    (prev != NULL ? prev->next : _head) = n;
+    free_block (b);
+    return iterator (n, 0);
+  }
+
+  // Append a new element to the list that ends with TAIL.
+  template <class... Args>
+  void
+  push_back (block *&tail, Args &&... args)
+  {
+    if (tail != NULL && tail->count < block_size)
+      {
+	new (tail->slots[tail->count].bytes) T (std::forward<Args> (args)...);
+	++tail->count;
+	return;
+      }
+    block *b = new_block (std::forward<Args> (args)...);
+    (tail != NULL ? tail->next : _head) = b;
+    tail = b;
+  }
+
+  void
+  destroy ()
+  {
+    while (_head != NULL)
+      {
+	block *b = _head;
+	_head = b->next;
+	if (!std::is_trivially_destructible<T>::value)
+	  for (size_type i = 0; i < b->count; ++i)
+	    b->payload (i).~T ();
+	free_block (b);
+      }
+  }
+
+  // Make AT the last element of its block, by moving the elements
+  // that follow it to a new block.  The iterators that FIX points to
+  // are kept at their elements.
+  static void
+  cut (const_iterator at, std::initializer_list<const_iterator *> fix)
+  {
+    block *b = const_cast<block *> (at._block);
+    size_type j = at._pos + 1;
+    if (j == b->count)
+      return;
+    block *n = alloc_block ();
+    relocate (b, j, b->count, n, 0);
+    n->count = b->count - j;
+    b->count = j;
+    n->next = b->next;
+    b->next = n;
+    for (auto it = fix.begin (); it != fix.end (); ++it)
+      if ((*it)->_block == b && (*it)->_pos >= j)
+	{
+	  (*it)->_block = n;
+	  (*it)->_pos -= j;
+	}
+  }
+
+  // Answer whether the elements of B and of the block after it fit
+  // in one block.
+  static bool
+  joinable (block const *b)
+  {
+    return b->next != NULL && b->count + b->next->count <= block_size;
+  }
+
+  // Move the elements of the block after B to B, and free that block.
+  static void
+  join (block *b)
+  {
+    block *n = b->next;
+    relocate (n, 0, n->count, b, b->count);
+    b->count += n->count;
+    b->next = n->next;
+    free_block (n);
+  }
+
+  // Answer chain A followed by chain B.
+  static block *
+  concat (block *a, block *b)
+  {
+    if (a == NULL)
+      return b;
+    block *t = a;
+    while (t->next != NULL)
+      t = t->next;
+    t->next = b;
+    return a;
+  }
+
+  // The first K elements of B were moved out.  Move the rest to the
+  // front and answer B.
+  static block *
+  shift (block *b, size_type k)
+  {
+    if (b != NULL && k > 0)
+      {
+	relocate (b, k, b->count, b, 0);
+	b->count -= k;
+      }
+    return b;
+  }
+
+  // Merge the sorted chain B into the sorted chain A.  Of equal
+  // elements, those of A come first.  Elements are moved to the tail
+  // block of the result one by one, except that a whole block that
+  // goes before the next element of the other chain is relinked.
+  // Blocks that run empty are reused for the result.  If COMP or an
+  // allocation throws, A ends up with all the elements, in no
+  // particular order.
+  template <class Compare>
+  static void
+  merge_chains (block *&a, block *b, Compare &comp)
+  {
+    block *x = a, *y = b;
+    size_type i = 0, j = 0;
+    block *head = NULL, *tail = NULL, *spare = NULL;
+    try
+      {
+	while (x != NULL && y != NULL)
+	  {
+	    bool from_y = comp (y->payload (j), x->payload (i));
+	    block *&from = from_y ? y : x;
+	    size_type &k = from_y ? j : i;
+
+	    if (k == 0
+		&& (from_y
+		    ? comp (y->payload (y->count - 1), x->payload (i))
+		    : !comp (y->payload (j), x->payload (x->count - 1))))
+	      {
+		block *whole = from;
+		from = from->next;
+		if (tail != NULL && tail->count + whole->count <= block_size)
+		  {
+		    relocate (whole, 0, whole->count, tail, tail->count);
+		    tail->count += whole->count;
+		    whole->next = spare;
+		    spare = whole;
+		  }
+		else
+		  {
+		    whole->next = NULL;
+		    (tail != NULL ? tail->next : head) = whole;
+		    tail = whole;
+		  }
+		continue;
+	      }
+
+	    if (tail == NULL || tail->count == block_size)
+	      {
+		block *n = spare;
+		if (n != NULL)
+		  spare = n->next;
+		else
+		  n = alloc_block ();
+		n->next = NULL;
+		n->count = 0;
+		(tail != NULL ? tail->next : head) = n;
+		tail = n;
+	      }
+	    relocate (from, k, tail, tail->count++);
+	    if (++k == from->count)
+	      {
+		block *done = from;
+		from = from->next;
+		k = 0;
+		done->next = spare;
+		spare = done;
+	      }
+	  }
+      }
+    catch (...)
+      {
+	a = concat (head, concat (shift (x, i), shift (y, j)));
+	free_chain (spare);
+	throw;
+      }
+
+    block *rest = x != NULL ? shift (x, i) : shift (y, j);
+    (tail != NULL ? tail->next : head) = rest;
+    if (tail != NULL && joinable (tail))
+      join (tail);
+    free_chain (spare);
+    a = head;
+  }
+
+  // Stable insertion sort of the elements of B.  Each element's place
+  // is found before anything moves, so if COMP throws, B still holds
+  // all its elements.
+  template <class Compare>
+  static void
+  sort_block (block *b, Compare &comp)
+  {
+    pointer p = &b->payload (0);
+    for (size_type i = 1; i < b->count; ++i)
+      std::rotate (std::upper_bound (p, p + i, p[i], comp), p + i, p + i + 1);
+  }
+
+  // Free the blocks of chain B, which hold no elements.
+  static void
+  free_chain (block *b)
+  {
+    while (b != NULL)
+      {
+	block *n = b->next;
+	free_block (b);
+	b = n;
+      }
+  }
+
+public:
+  unrolled_list ()
+    : _head (NULL)
+  {}
+
+  // The copy has all blocks full but the last one.
+  unrolled_list (unrolled_list const &copy)
+    : _head (NULL)
+  {
+    block *tail = NULL;
+    for (auto it = copy.begin (); it != copy.end (); ++it)
+      push_back (tail, *it);
+  }
+
+  unrolled_list (unrolled_list &&other)
+    : _head (NULL)
+  {
+    swap (other);
+  }
+
+  template <class InputIterator>
+  unrolled_list (InputIterator first, InputIterator last)
+    : _head (NULL)
+  {
+    block *tail = NULL;
+    for (; first != last; ++first)
+      push_back (tail, *first);
+  }
+
+  unrolled_list (size_t n, T const &value = T ())
+    : _head (NULL)
+  {
+    block *tail = NULL;
+    for (size_t i = 0; i < n; ++i)
+      push_back (tail, value);
+  }
+
+  ~unrolled_list ()
+  {
+    destroy ();
+  }
+
+  void
+  swap (unrolled_list &other)
+  {
+    std::swap (_head, other._head);
+  }
+
+  unrolled_list &
+  operator = (unrolled_list other)
+  {
+    swap (other);
+    return *this;
+  }
+
+  void
+  clear ()
+  {
+    destroy ();
+  }
+
+  void
+  resize (size_t n, T const &value = T ())
+  {
+    if (n == 0)
+      {
+	clear ();
+	return;
+      }
+
+    if (empty ())
+      push_front (value);
+    iterator it = begin ();
+    size_t i = 1;
+    for (; i < n && std::next (it) != end (); ++i)
+      ++it;
+    if (i == n)
+      erase_after (it, end ());
+    else
+      for (; i < n; ++i)
+	it = insert_after (it, value);
+  }
+
+  template <class... Args>
+  void
+  emplace_front (Args &&... args)
+  {
+    if (_head != NULL && _head->count < block_size)
+      insert_at (_head, 0, std::forward<Args> (args)...);
+    else
+      {
+	block *b = new_block (std::forward<Args> (args)...);
+	b->next = _head;
+	_head = b;
+      }
+  }
+
+  void
+  push_front (const T &value)
+  {
+    emplace_front (value);
+  }
+
+  void
+  push_front (T &&value)
+  {
+    emplace_front (std::move (value));
+  }
+
+  template <class... Args>
+  iterator
+  emplace_after (const_iterator it, Args &&... args)
+  {
+    assert (it._block != NULL);
+    return insert_at (const_cast<block *> (it._block), it._pos + 1,
+		      std::forward<Args> (args)...);
+  }
+
+  iterator
+  insert_after (const_iterator it, const T &value)
+  {
+    return emplace_after (it, value);
+  }
+
+  iterator
+  insert_after (const_iterator it, T &&value)
+  {
+    return emplace_after (it, std::move (value));
+  }
+
+  void
+  pop_front ()
+  {
+    assert (_head != NULL);
+    erase_front (NULL, _head);
+  }
+
+  iterator
+  erase_after (const_iterator it)
+  {
+    assert (it._block != NULL);
+    block *b = const_cast<block *> (it._block);
+    size_type j = it._pos + 1;
+    if (j < b->count)
+      return erase_at (b, j);
+    return erase_front (b, b->next);
+  }
+
+  // Erase the elements between FIRST and LAST.  Answer the iterator
+  // that follows FIRST, which is where LAST's element ends up.
+  iterator
+  erase_after (const_iterator first, const_iterator last)
+  {
+    size_t n = 0;
+    for (const_iterator it = std::next (first); it != last; ++it)
+      ++n;
+    for (; n > 0; --n)
+      erase_after (first);
+    block *b = const_cast<block *> (first._block);
+    return iter (b, first._pos + 1);
+  }
+
+  // The following operations have the semantics of their
+  // std::forward_list namesakes, except that they invalidate
+  // iterators.  Elements that change blocks are moved.
+
+  // Move all elements of OTHER after IT.
+  void
+  splice_after (const_iterator it, unrolled_list &other)
+  {
+    assert (&other != this);
+    if (other.empty ())
+      return;
+    cut (it, {});
+    block *b = const_cast<block *> (it._block);
+    block *t = other._head;
+    while (t->next != NULL)
+      t = t->next;
+    t->next = b->next;
+    b->next = other._head;
+    other._head = NULL;
+    if (joinable (t))
+      join (t);
+    if (joinable (b))
+      join (b);
+  }
+
+  // Move the element after FROM in OTHER after IT.
+  void
+  splice_after (const_iterator it, unrolled_list &other, const_iterator from)
+  {
+    const_iterator last = std::next (from);
+    if (&other == this && (it == from || it == last))
+      return;
+    splice_after (it, other, from, ++last);
+  }
+
+  // Move the elements strictly between FIRST and LAST in OTHER after
+  // IT.
+  void
+  splice_after (const_iterator it, unrolled_list &other,
+		const_iterator first, const_iterator last)
+  {
+    if (std::next (first) == last)
+      return;
+
+    // The last element of the range.
+    const_iterator back;
+    if (last._block != NULL && last._pos > 0)
+      back = const_iterator (last._block, last._pos - 1);
+    else
+      {
+	block const *b = first._block;
+	while (b->next != last._block)
+	  b = b->next;
+	back = const_iterator (b, b->count - 1);
+      }
+
+    // Cut the blocks so that the range is whole blocks, and move them
+    // over.
+    cut (back, {&first, &it});
+    cut (first, {&back, &it});
+    cut (it, {&first, &back});
+    block *f = const_cast<block *> (first._block);
+    block *e = const_cast<block *> (back._block);
+    block *b = const_cast<block *> (it._block);
+    block *range = f->next;
+    f->next = e->next;
+    e->next = b->next;
+    b->next = range;
+
+    // Join blocks where the cuts were.  A seam whose block gets joined
+    // to the one before it moves there.
+    block *seams[] = { e, b, f };
+    for (size_t k = 0; k < 3; ++k)
+      if (joinable (seams[k]))
+	{
+	  for (size_t l = k + 1; l < 3; ++l)
+	    if (seams[l] == seams[k]->next)
+	      seams[l] = seams[k];
+	  join (seams[k]);
+	}
+  }
+
+  // Merge sorted OTHER into this sorted list.  OTHER ends up empty.
+  // Of equal elements, those of this list come first.  If COMP
+  // throws, or a block can't be allocated, all elements end up in
+  // this list in no particular order.
+  template <class Compare>
+  void
+  merge (unrolled_list &other, Compare comp)
+  {
+    if (&other == this)
+      return;
+    block *b = other._head;
+    other._head = NULL;
+    merge_chains (_head, b, comp);
+  }
+
+  void
+  merge (unrolled_list &other)
+  {
+    merge (other, std::less<T> ());
+  }
+
+  // Stable bottom-up merge sort of blocks, each of which is sorted
+  // first.  BINS[K] holds a sorted chain of 2^K blocks' worth of
+  // elements, or is empty, like the bits of a binary counter.  If
+  // COMP throws, or a block can't be allocated, the list keeps all
+  // elements in no particular order.
+  template <class Compare>
+  void
+  sort (Compare comp)
+  {
+    block *bins[sizeof (size_t) * 8];
+    size_t used = 0;
+    block *chain = NULL;
+    try
+      {
+	while (_head != NULL)
+	  {
+	    chain = _head;
+	    _head = chain->next;
+	    chain->next = NULL;
+	    sort_block (chain, comp);
+
+	    size_t k = 0;
+	    for (; k < used && bins[k] != NULL; ++k)
+	      {
+		block *b = chain;
+		chain = bins[k];
+		bins[k] = NULL;
+		merge_chains (chain, b, comp);
+	      }
+	    if (k == used)
+	      ++used;
+	    bins[k] = chain;
+	    chain = NULL;
+	  }
+
+	// Higher bins hold earlier elements.
+	for (size_t k = 0; k < used; ++k)
+	  if (bins[k] != NULL)
+	    {
+	      block *b = chain;
+	      chain = bins[k];
+	      bins[k] = NULL;
+	      merge_chains (chain, b, comp);
+	    }
+      }
+    catch (...)
+      {
+	for (size_t k = 0; k < used; ++k)
+	  chain = concat (bins[k], chain);
+	_head = concat (chain, _head);
+	throw;
+      }
+    _head = chain;
+  }
+
+  void
+  sort ()
+  {
+    sort (std::less<T> ());
+  }
+
+  // Reverse the order of the blocks, and of the elements in each.
+  void
+  reverse ()
+  {
+    block *prev = NULL;
+    for (block *b = _head; b != NULL; )
+      {
+	pointer p = &b->payload (0);
+	std::reverse (p, p + b->count);
+	block *next = b->next;
+	b->next = prev;
+	prev = b;
+	b = next;
+      }
+    _head = prev;
+  }
+
+  reference
+  front ()
+  {
+    return *begin ();
+  }
+
+  const_reference
+  front () const
+  {
+    return *begin ();
+  }
+
+  bool
+  empty () const
+  {
+    return _head == NULL;
+  }
+
+  iterator
+  begin ()
+  {
+    return iterator (_head, 0);
+  }
+
+  const_iterator
+  begin () const
+  {
+    return const_iterator (_head, 0);
+  }
+
+  const_iterator
+  cbegin () const
+  {
+    return begin ();
+  }
+
+  iterator
+  end ()
+  {
+    return iterator (NULL, 0);
+  }
+
+  const_iterator
+  end () const
+  {
+    return const_iterator (NULL, 0);
+  }
+
+  const_iterator
+  cend () const
+  {
+    return end ();
+  }
+
+  bool
+  operator == (unrolled_list const &other) const
+  {
+    const_iterator it = begin ();
+    const_iterator jt = other.begin ();
+    for (; it != end () && jt != other.end (); ++it, ++jt)
+      if (*it != *jt)
+	return false;
+    return (it == end ()) == (jt == other.end ());
+  }
+
+  bool
+  operator != (unrolled_list const &other) const
+  {
+    return !(*this == other);
+  }
+};
+
+template<class T, size_t Bytes>
+void
+swap (unrolled_list<T, Bytes> &l1, unrolled_list<T, Bytes> &l2)
+{
+  l1.swap (l2);
+}
+
+#endif /* _UNROLLED_LIST_H_ */